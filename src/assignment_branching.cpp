@@ -0,0 +1,71 @@
+#include <algorithm>
+#include <cmath>
+#include "assignment_branching.h"
+#include "assignment_cons.h"
+#include "vardata.h"
+
+AssignmentBranching::AssignmentBranching(SCIP* scip, size_t num_superpixels_, const std::vector<Graph::vertex_descriptor>& master_nodes_) :
+    ObjBranchrule(scip, "assignment", "branching on the assignment of superpixels to master nodes", 50000, -1, 1.0),
+    num_superpixels(num_superpixels_), master_nodes(master_nodes_), master_index(num_superpixels_, 0),
+    assignment(num_superpixels_ * master_nodes_.size()), branchings(0)
+{
+    for (size_t i = 0; i < master_nodes.size(); ++i)
+    {
+        master_index[master_nodes[i]] = i;
+    }
+}
+
+SCIP_DECL_BRANCHEXECLP(AssignmentBranching::scip_execlp)
+{
+    std::fill(assignment.begin(), assignment.end(), 0.0);
+    SCIP_VAR** vars = SCIPgetVars(scip);
+    for (int j = 0; j < SCIPgetNVars(scip); ++j)
+    {
+        SCIP_Real value = SCIPgetSolVal(scip, NULL, vars[j]);
+        auto vardata = getSegmentVardata(scip, vars[j]);
+        if (vardata == NULL || !SCIPisFeasPositive(scip, value))
+        {
+            continue;
+        }
+        size_t i = master_index[vardata->getMasterNode()];
+        for (const uint32_t* s = vardata->begin(); s != vardata->end(); ++s)
+        {
+            assignment[*s * master_nodes.size() + i] += value;
+        }
+    }
+
+    // the most fractional assignment, the smallest superpixel and master node on ties
+    size_t best = assignment.size();
+    SCIP_Real best_distance = 0.5;
+    for (size_t k = 0; k < assignment.size(); ++k)
+    {
+        SCIP_Real distance = std::abs(assignment[k] - 0.5);
+        if (SCIPisFeasPositive(scip, assignment[k]) && SCIPisFeasLT(scip, assignment[k], 1.0) && distance < best_distance)
+        {
+            best = k;
+            best_distance = distance;
+        }
+    }
+    if (best == assignment.size())
+    {
+        *result = SCIP_DIDNOTRUN;
+        return SCIP_OKAY;
+    }
+
+    Graph::vertex_descriptor s = best / master_nodes.size();
+    Graph::vertex_descriptor t = master_nodes[best % master_nodes.size()];
+    AssignmentDecision::Type types[] = {AssignmentDecision::SAME, AssignmentDecision::DIFFER};
+    for (auto type : types)
+    {
+        SCIP_NODE* child;
+        SCIP_CONS* cons;
+        SCIP_CALL(SCIPcreateChild(scip, &child, 0.0, SCIPgetLocalTransEstimate(scip)));
+        SCIP_CALL(SCIPcreateConsAssignment(scip, &cons, type == AssignmentDecision::SAME ? "same" : "differ",
+            AssignmentDecision{s, t, type}));
+        SCIP_CALL(SCIPaddConsNode(scip, child, cons, NULL));
+        SCIP_CALL(SCIPreleaseCons(scip, &cons));
+    }
+    ++branchings;
+    *result = SCIP_BRANCHED;
+    return SCIP_OKAY;
+}
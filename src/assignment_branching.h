@@ -0,0 +1,54 @@
+#ifndef ASSIGNMENT_BRANCHING_H
+#define ASSIGNMENT_BRANCHING_H
+
+#include <objscip/objscip.h>
+#include <vector>
+#include "graph.h"
+
+using namespace scip;
+
+/**
+ * Branching rule on the assignment of superpixels to master nodes
+ * Every segment contains exactly one master node, so an LP solution assigns each superpixel \f$s\f$ to the master node \f$t\f$
+ * with the value \f$a_{st} = \sum_{P\ni s,\, t\in P}x_P\f$. If all these values are integral, so is the LP solution,
+ * since then all segments of a master node with positive value are equal.
+ * Otherwise the superpixel and master node with \f$a_{st}\f$ closest to 0.5 are chosen, and two children are created:
+ * one in which \f$s\f$ belongs to the segment of \f$t\f$, and one in which it does not.
+ * The decisions are stored in `AssignmentCons` constraints and also enforced in the pricing problems,
+ * so the pricer never generates a segment violating them. Both children change the solution of every pricing problem
+ * involving \f$s\f$ or \f$t\f$, so the tree is much more balanced than when branching on single segment variables.
+ *
+ * If the current LP solution only uses artificial segments fractionally, no decision is found and the rule
+ * leaves the node to the other branching rules.
+ */
+class AssignmentBranching : public ObjBranchrule
+{
+public:
+    AssignmentBranching(
+        SCIP* scip, ///< master SCIP instance
+        size_t num_superpixels, ///< number of superpixels
+        const std::vector<Graph::vertex_descriptor>& master_nodes ///< master nodes of all segments
+        );
+
+    /**
+     * Branching execution method for fractional LP solutions
+     */
+    virtual SCIP_DECL_BRANCHEXECLP(scip_execlp);
+
+    /**
+     * @return the number of nodes branched on so far
+     */
+    size_t getBranchings() const
+    {
+        return branchings;
+    }
+
+private:
+    size_t num_superpixels;
+    std::vector<Graph::vertex_descriptor> master_nodes;
+    std::vector<size_t> master_index; ///< `master_index[t]` is the index of the master node `t` in `master_nodes`
+    std::vector<SCIP_Real> assignment; ///< \f$a_{st}\f$ at index `s * master_nodes.size() + master_index[t]`
+    size_t branchings;
+};
+
+#endif
@@ -0,0 +1,126 @@
+#include "assignment_cons.h"
+#include "vardata.h"
+
+struct SCIP_ConsData
+{
+    AssignmentDecision decision;
+};
+
+AssignmentCons::AssignmentCons(SCIP* scip) :
+    ObjConshdlr(scip, "assignment", "Branching decisions on the assignment of superpixels to master nodes",
+        0, 0, 9999999, -1, 1, 1, 0,
+        FALSE, FALSE, TRUE, SCIP_PROPTIMING_BEFORELP, SCIP_PRESOLTIMING_FAST),
+    prop_fixings(0)
+{}
+
+SCIP_DECL_CONSDELETE(AssignmentCons::scip_delete)
+{
+    delete *consdata;
+    *consdata = NULL;
+    return SCIP_OKAY;
+}
+
+SCIP_DECL_CONSTRANS(AssignmentCons::scip_trans)
+{
+    SCIP_CONSDATA* sourcedata = SCIPconsGetData(sourcecons);
+    SCIP_CALL(SCIPcreateCons(scip, targetcons, SCIPconsGetName(sourcecons), conshdlr, new SCIP_ConsData(*sourcedata),
+        SCIPconsIsInitial(sourcecons), SCIPconsIsSeparated(sourcecons), SCIPconsIsEnforced(sourcecons),
+        SCIPconsIsChecked(sourcecons), SCIPconsIsPropagated(sourcecons),  SCIPconsIsLocal(sourcecons),
+        SCIPconsIsModifiable(sourcecons), SCIPconsIsDynamic(sourcecons), SCIPconsIsRemovable(sourcecons),
+        SCIPconsIsStickingAtNode(sourcecons)));
+
+    return SCIP_OKAY;
+}
+
+SCIP_DECL_CONSENFOLP(AssignmentCons::scip_enfolp)
+{
+    *result = SCIP_FEASIBLE;
+    return SCIP_OKAY;
+}
+
+SCIP_DECL_CONSENFOPS(AssignmentCons::scip_enfops)
+{
+    *result = SCIP_FEASIBLE;
+    return SCIP_OKAY;
+}
+
+SCIP_DECL_CONSCHECK(AssignmentCons::scip_check)
+{
+    *result = SCIP_FEASIBLE;
+    return SCIP_OKAY;
+}
+
+SCIP_DECL_CONSLOCK(AssignmentCons::scip_lock)
+{
+    return SCIP_OKAY;
+}
+
+SCIP_DECL_CONSPROP(AssignmentCons::scip_prop)
+{
+    *result = SCIP_DIDNOTFIND;
+    SCIP_VAR** vars = SCIPgetVars(scip);
+    for (int c = 0; c < nconss; ++c)
+    {
+        const AssignmentDecision& decision = SCIPconsGetData(conss[c])->decision;
+        for (int j = 0; j < SCIPgetNVars(scip); ++j)
+        {
+            if (SCIPvarGetUbLocal(vars[j]) < 0.5)
+            {
+                continue;
+            }
+            auto vardata = getSegmentVardata(scip, vars[j]);
+            if (vardata != NULL && decision.allows(vardata->getMasterNode(), vardata->containsSuperpixel(decision.superpixel)))
+            {
+                continue;
+            }
+            SCIP_Bool infeasible;
+            SCIP_Bool tightened;
+            SCIP_CALL(SCIPinferBinvarCons(scip, vars[j], FALSE, conss[c], 0, &infeasible, &tightened));
+            if (infeasible)
+            {
+                *result = SCIP_CUTOFF;
+                return SCIP_OKAY;
+            }
+            if (tightened)
+            {
+                ++prop_fixings;
+                *result = SCIP_REDUCEDDOM;
+            }
+        }
+    }
+    return SCIP_OKAY;
+}
+
+SCIP_DECL_CONSACTIVE(AssignmentCons::scip_active)
+{
+    active.push_back(SCIPconsGetData(cons)->decision);
+    return SCIP_OKAY;
+}
+
+SCIP_DECL_CONSDEACTIVE(AssignmentCons::scip_deactive)
+{
+    // the nodes are deactivated in the reverse order of their activation
+    active.pop_back();
+    return SCIP_OKAY;
+}
+
+SCIP_RETCODE SCIPcreateConsAssignment(
+    SCIP* scip,
+    SCIP_CONS** cons,
+    const char* name,
+    const AssignmentDecision& decision
+    )
+{
+    SCIP_CONSHDLR* conshdlr = SCIPfindConshdlr(scip, "assignment");
+    if (conshdlr == NULL)
+    {
+        SCIPerrorMessage("assignment constraint handler not found\n");
+        return SCIP_PLUGINNOTFOUND;
+    }
+
+    // the decision only holds in the subtree of the node the constraint is added to
+    SCIP_CALL(SCIPcreateCons(scip, cons, name, conshdlr, new SCIP_ConsData{decision},
+        FALSE, FALSE, FALSE, FALSE, TRUE, TRUE, FALSE, FALSE, FALSE, TRUE));
+
+    return SCIP_OKAY;
+}
@@ -0,0 +1,132 @@
+#ifndef ASSIGNMENT_CONS_H
+#define ASSIGNMENT_CONS_H
+
+#include <objscip/objscip.h>
+#include <vector>
+#include "graph.h"
+
+using namespace scip;
+
+/**
+ * Branching decision on the assignment of a superpixel to the segment of a master node
+ */
+struct AssignmentDecision
+{
+    enum Type
+    {
+        DIFFER, ///< the superpixel is not contained in the segment of the master node
+        SAME ///< the superpixel is contained in the segment of the master node
+    };
+
+    Graph::vertex_descriptor superpixel;
+    Graph::vertex_descriptor master_node;
+    Type type;
+
+    /**
+     * @return whether a segment of `segment_master_node` containing the superpixel iff `contains` respects the decision
+     */
+    bool allows(Graph::vertex_descriptor segment_master_node, bool contains) const
+    {
+        if (segment_master_node == master_node)
+        {
+            return contains == (type == SAME);
+        }
+        return !(contains && type == SAME);
+    }
+};
+
+/**
+ * Constraint handler for the branching decisions of `AssignmentBranching` in the master problem
+ * Each constraint is local to the node of the branch-and-bound tree it was created for and holds one decision.
+ * The decisions of the active constraints, i.e. those on the path to the current node, are kept in a stack,
+ * which the pricer reads to fix the variables of its pricing problems.
+ *
+ * In `scip_prop`, all segment variables violating one of the active decisions are fixed to 0.
+ * The artificial initial segments (variables without variable data) are fixed to 0 below the root,
+ * infeasible nodes are resolved by Farkas pricing instead.
+ * The constraints are never violated by a solution in which these fixings hold, so the enforcement and check are trivial.
+ */
+class AssignmentCons : public ObjConshdlr
+{
+public:
+    AssignmentCons(
+        SCIP* scip ///< master SCIP instance
+        );
+
+    /**
+     * Frees the decision of a constraint
+     */
+    virtual SCIP_DECL_CONSDELETE(scip_delete);
+
+    /**
+     * Transforms constraint data into data belonging to the transformed problem
+     */
+    virtual SCIP_DECL_CONSTRANS(scip_trans);
+
+    /**
+     * Constraint enforcing method of constraint handler for LP solutions
+     */
+    virtual SCIP_DECL_CONSENFOLP(scip_enfolp);
+
+    /**
+     * Constraint enforcing method of constraint handler for pseudo solutions
+     */
+    virtual SCIP_DECL_CONSENFOPS(scip_enfops);
+
+    /**
+     * Feasibility check method of constraint handler for primal solutions
+     */
+    virtual SCIP_DECL_CONSCHECK(scip_check);
+
+    /**
+     * Variable rounding lock method of constraint handler
+     */
+    virtual SCIP_DECL_CONSLOCK(scip_lock);
+
+    /**
+     * Domain propagation method of constraint handler
+     */
+    virtual SCIP_DECL_CONSPROP(scip_prop);
+
+    /**
+     * Pushes the decision of a constraint whose node becomes active
+     */
+    virtual SCIP_DECL_CONSACTIVE(scip_active);
+
+    /**
+     * Pops the decision of a constraint whose node becomes inactive
+     */
+    virtual SCIP_DECL_CONSDEACTIVE(scip_deactive);
+
+    /**
+     * @return the decisions on the path from the root to the current node
+     */
+    const std::vector<AssignmentDecision>& getActiveDecisions() const
+    {
+        return active;
+    }
+
+    /**
+     * @return the number of variables fixed by `scip_prop` so far
+     */
+    size_t getPropFixings() const
+    {
+        return prop_fixings;
+    }
+
+private:
+    std::vector<AssignmentDecision> active;
+    size_t prop_fixings;
+};
+
+/**
+ * Creates an assignment constraint holding a branching decision
+ */
+SCIP_RETCODE SCIPcreateConsAssignment(
+    SCIP* scip, ///< master SCIP instance
+    SCIP_CONS** cons, ///< pointer to hold the created constraint
+    const char* name, ///< name of the constraint
+    const AssignmentDecision& decision ///< the branching decision
+    );
+
+#endif
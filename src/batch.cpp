@@ -0,0 +1,160 @@
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include "batch.h"
+#include "threadpool.h"
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    double secondsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    /**
+     * Reads the image, maps the seeds to master nodes and segments the image
+     */
+    ExitStatus processJob(const BatchJob& job, const SolverOptions& options, RunStats& stats)
+    {
+        stats.image = job.image;
+        std::unique_ptr<Image> image;
+        try
+        {
+            image.reset(new Image(job.image, job.superpixels, job.output_prefix));
+        }
+        catch (std::exception& e)
+        {
+            std::cerr << "Cannot read " << job.image << ": " << e.what() << std::endl;
+            return STATUS_INPUT;
+        }
+
+        std::vector<Graph::vertex_descriptor> master_nodes;
+        if (!masterNodesFromSeeds(job.seeds, *image, master_nodes))
+        {
+            return STATUS_INPUT;
+        }
+        if (master_nodes.empty())
+        {
+            std::cerr << "No master nodes given for " << job.image << std::endl;
+            return STATUS_INPUT;
+        }
+        return segmentImage(*image, master_nodes, options, true, stats);
+    }
+}
+
+bool readManifest(const std::string& filename, std::vector<BatchJob>& jobs)
+{
+    std::ifstream file(filename);
+    if (!file)
+    {
+        std::cerr << "Cannot read manifest " << filename << std::endl;
+        return false;
+    }
+    std::string line;
+    size_t number = 0;
+    while (std::getline(file, line))
+    {
+        ++number;
+        std::stringstream stream(line);
+        BatchJob job;
+        std::string seeds, rest;
+        if (!(stream >> job.image) || job.image[0] == '#')
+        {
+            continue;
+        }
+        if (!(stream >> job.superpixels) || job.superpixels < 1 || !(stream >> seeds))
+        {
+            std::cerr << filename << ":" << number << ": expected \"image num_superpixels seeds_file [output_prefix]\"" << std::endl;
+            return false;
+        }
+        if (!(stream >> job.output_prefix))
+        {
+            std::string stem = job.image;
+            if (stem.size() > 4 && stem.compare(stem.size() - 4, 4, ".png") == 0)
+            {
+                stem.resize(stem.size() - 4);
+            }
+            job.output_prefix = stem + "_";
+        }
+        if (stream >> rest)
+        {
+            std::cerr << filename << ":" << number << ": unexpected \"" << rest << "\"" << std::endl;
+            return false;
+        }
+        if (!readSeedsFile(seeds, job.seeds))
+        {
+            return false;
+        }
+        jobs.push_back(job);
+    }
+    return true;
+}
+
+ExitStatus runBatch(const std::vector<BatchJob>& jobs, size_t parallel_jobs, const SolverOptions& options, const std::string& report)
+{
+    std::vector<ExitStatus> status(jobs.size(), STATUS_OK);
+    std::vector<RunStats> stats(jobs.size());
+    std::vector<double> total(jobs.size(), 0.0);
+    std::mutex output;
+
+    auto start = Clock::now();
+    ThreadPool pool(parallel_jobs);
+    pool.run(jobs.size(), [&](size_t i) {
+        auto job_start = Clock::now();
+        status[i] = processJob(jobs[i], options, stats[i]);
+        total[i] = secondsSince(job_start);
+
+        const PhaseTimes& times = stats[i].phases;
+        std::lock_guard<std::mutex> lock(output);
+        std::cout << jobs[i].image << ": " << (status[i] == STATUS_OK ? "ok" : "failed")
+            << ", load " << times.load << " s"
+            << ", slic " << times.slic << " s"
+            << ", graph " << times.graph << " s"
+            << ", setup " << times.setup << " s"
+            << ", solve " << times.solve << " s"
+            << ", render " << times.render << " s"
+            << ", total " << total[i] << " s" << std::endl;
+    });
+    double elapsed = secondsSince(start);
+
+    size_t succeeded = 0;
+    ExitStatus result = STATUS_OK;
+    for (size_t i = 0; i < jobs.size(); ++i)
+    {
+        if (status[i] == STATUS_OK)
+        {
+            ++succeeded;
+        }
+        else if (result == STATUS_OK)
+        {
+            result = status[i];
+        }
+    }
+    std::cout << "Segmented " << succeeded << " of " << jobs.size() << " images in " << elapsed << " s"
+        << " using " << pool.size() << " workers" << std::endl;
+
+    if (!report.empty())
+    {
+        std::ofstream file(report);
+        file << "[" << std::endl;
+        for (size_t i = 0; i < jobs.size(); ++i)
+        {
+            stats[i].writeJson(file);
+            if (i + 1 < jobs.size())
+            {
+                file << "," << std::endl;
+            }
+        }
+        file << "]" << std::endl;
+        if (!file)
+        {
+            std::cerr << "Cannot write report " << report << std::endl;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,45 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <string>
+#include <vector>
+#include "master.h"
+#include "seeds.h"
+
+/**
+ * One image to be segmented by the batch driver
+ */
+struct BatchJob
+{
+    std::string image; ///< PNG image to read
+    int superpixels; ///< desired number of superpixels
+    Seeds seeds; ///< master nodes of the segments
+    std::string output_prefix; ///< prepended to the names of all files written for this image
+};
+
+/**
+ * Reads a manifest describing a batch of images
+ * Every non-empty line not starting with `#` has the form `image num_superpixels seeds_file [output_prefix]`.
+ * The seeds file has the format accepted by `readSeedsFile`. Without an output prefix, the image path
+ * without its `.png` extension followed by `_` is used, e.g. `input1.png` is segmented into `input1_segments.png`.
+ * @return false if the manifest or one of the seeds files cannot be read or contains an invalid line
+ */
+bool readManifest(
+    const std::string& filename, ///< manifest file
+    std::vector<BatchJob>& jobs ///< the jobs are appended to this
+    );
+
+/**
+ * Segments all images of a batch concurrently and prints the time spent on each image
+ * Every job runs on one worker of a pool of `parallel_jobs` threads with its own SCIP instance.
+ * A failing job is reported and does not stop the remaining jobs.
+ * @return `STATUS_OK` if all images were segmented, otherwise the status of the first failed job in manifest order
+ */
+ExitStatus runBatch(
+    const std::vector<BatchJob>& jobs, ///< the images to segment
+    size_t parallel_jobs, ///< number of images processed at the same time, 0 for one per hardware thread
+    const SolverOptions& options, ///< options of each job, including the number of threads used within it
+    const std::string& report ///< if not empty, the statistics of all jobs are written to this file as a JSON array, see `RunStats`
+    );
+
+#endif
@@ -0,0 +1,485 @@
+/** @file */
+
+#include <boost/graph/connected_components.hpp>
+#include <scip/scipdefplugins.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "graph.h"
+#include "csr_graph.h"
+#include "image.h"
+#include "graph_builder.h"
+#include "connectivity_checker.h"
+#include "connectivity_cons.h"
+#include "connected_subgraph_solver.h"
+#include "pricer.h"
+#include "master.h"
+#include "seeds.h"
+
+/**
+ * Average running time of one benchmark
+ */
+struct BenchmarkResult
+{
+    std::string name; ///< the stage that was measured
+    std::string input; ///< the image or synthetic input the stage was run on
+    size_t superpixels; ///< number of superpixels of the input
+    size_t repetitions; ///< number of calls the average is taken over
+    double us_per_call; ///< average wall-clock time per call in microseconds
+};
+
+std::vector<BenchmarkResult> results; ///< results of all benchmarks run so far
+std::string current_input; ///< input of the benchmarks run next, see `beginInput`
+size_t current_superpixels = 0;
+size_t check_failures = 0; ///< number of failed correctness checks, the benchmark fails if it is positive
+
+/**
+ * Starts a group of benchmarks on the same input
+ */
+void beginInput(const std::string& input, size_t superpixels)
+{
+    current_input = input;
+    current_superpixels = superpixels;
+    std::cout << input << ", " << superpixels << " superpixels" << std::endl;
+}
+
+/**
+ * Stores and prints the result of a benchmark on the current input
+ */
+void record(const std::string& name, size_t repetitions, double us_per_call)
+{
+    results.push_back(BenchmarkResult{name, current_input, current_superpixels, repetitions, us_per_call});
+    std::cout << "  " << name << ": " << us_per_call << " us/call" << std::endl;
+}
+
+/**
+ * Calls `f` `repetitions` times and records the average running time per call
+ */
+template<typename F>
+void measure(const std::string& name, size_t repetitions, F f)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < repetitions; ++i)
+    {
+        f(i);
+    }
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    record(name, repetitions, elapsed.count() / repetitions);
+}
+
+/**
+ * Writes all results as JSON, so that they can be compared across releases
+ */
+bool writeJson(const std::string& filename)
+{
+    std::ofstream file(filename);
+    if (!file)
+    {
+        std::cerr << "Cannot write " << filename << std::endl;
+        return false;
+    }
+    file << "{" << std::endl;
+    file << "  \"hardware_threads\": " << std::thread::hardware_concurrency() << "," << std::endl;
+    file << "  \"benchmarks\": [" << std::endl;
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const BenchmarkResult& r = results[i];
+        file << "    {\"name\": \"" << r.name << "\", \"input\": \"" << r.input << "\", \"superpixels\": " << r.superpixels
+            << ", \"repetitions\": " << r.repetitions << ", \"us_per_call\": " << r.us_per_call << "}"
+            << (i + 1 < results.size() ? "," : "") << std::endl;
+    }
+    file << "  ]" << std::endl;
+    file << "}" << std::endl;
+    return true;
+}
+
+/**
+ * Compares the connectivity check using a Boost subgraph, as formerly done in ConnectivityCons,
+ * with the ConnectivityChecker
+ */
+void benchConnectivity(Graph& g, size_t repetitions)
+{
+    size_t n = num_vertices(g);
+
+    // random selections of about half of the superpixels
+    std::mt19937 rng(42);
+    std::bernoulli_distribution coin(0.5);
+    std::vector<std::vector<bool>> selections(repetitions, std::vector<bool>(n));
+    for (auto& selection : selections)
+    {
+        for (size_t s = 0; s < n; ++s)
+        {
+            selection[s] = coin(rng);
+        }
+    }
+
+    size_t checksum_subgraph = 0;
+    measure("connectivity (boost subgraph)", repetitions, [&](size_t i) {
+        Graph& subgraph = g.create_subgraph();
+        std::vector<int> component(n);
+        for (size_t s = 0; s < n; ++s)
+        {
+            if (selections[i][s])
+            {
+                add_vertex(s, subgraph);
+            }
+        }
+        checksum_subgraph += connected_components(subgraph, &component[0]);
+        delete &subgraph;
+        g.m_children.clear();
+    });
+
+    CsrGraph csr(g);
+    ConnectivityChecker checker(csr);
+    size_t checksum_checker = 0;
+    measure("connectivity (ConnectivityChecker)", repetitions, [&](size_t i) {
+        for (size_t s = 0; s < n; ++s)
+        {
+            checker.select(s, selections[i][s]);
+        }
+        checksum_checker += checker.findComponents();
+    });
+
+    if (checksum_subgraph != checksum_checker)
+    {
+        std::cerr << "  number of components differ: " << checksum_subgraph << " != " << checksum_checker << std::endl;
+    }
+}
+
+/**
+ * Compares the ConnectedSubgraphSolver with the exhaustive enumeration of all connected segments on small random graphs
+ * Some superpixels are forbidden, excluded or required, as in the pricing problems below the root.
+ * @return the number of instances on which the optimal values differ
+ */
+size_t checkSubgraphSolver(size_t instances)
+{
+    std::mt19937 rng(42);
+    size_t mismatches = 0;
+    for (size_t k = 0; k < instances; ++k)
+    {
+        uint32_t n = 3 + rng() % 10;
+        Graph g(n);
+        for (uint32_t u = 0; u < n; ++u)
+        {
+            for (uint32_t v = u + 1; v < n; ++v)
+            {
+                if (rng() % 3 == 0)
+                {
+                    add_edge(u, v, g);
+                }
+            }
+        }
+        CsrGraph csr(g);
+        ConnectedSubgraphSolver solver(csr);
+        uint32_t root = rng() % n;
+        std::vector<SCIP_Real> weights(n);
+        uint32_t forbidden = 0; // bit masks of superpixels
+        uint32_t required = 0;
+        for (uint32_t s = 0; s < n; ++s)
+        {
+            weights[s] = (int(rng() % 21) - 10) * 0.5;
+            solver.setWeight(s, weights[s]);
+            int kind = s == root ? -1 : int(rng() % 10);
+            if (kind == 0)
+            {
+                solver.forbid(s);
+                forbidden |= 1u << s;
+            }
+            else if (kind == 1)
+            {
+                solver.exclude(s);
+                forbidden |= 1u << s;
+            }
+            else if (kind == 2)
+            {
+                solver.require(s);
+                required |= 1u << s;
+            }
+        }
+
+        SCIP_Real best = std::numeric_limits<SCIP_Real>::infinity();
+        for (uint32_t segment = 1u << root; segment < (1u << n); ++segment)
+        {
+            if (!(segment >> root & 1) || (segment & forbidden) != 0 || (segment & required) != required)
+            {
+                continue;
+            }
+            uint32_t reached = 1u << root;
+            std::vector<uint32_t> stack(1, root);
+            while (!stack.empty())
+            {
+                uint32_t v = stack.back();
+                stack.pop_back();
+                for (const uint32_t* w = csr.neighboursBegin(v); w != csr.neighboursEnd(v); ++w)
+                {
+                    if ((segment >> *w & 1) && !(reached >> *w & 1))
+                    {
+                        reached |= 1u << *w;
+                        stack.push_back(*w);
+                    }
+                }
+            }
+            if (reached == segment)
+            {
+                SCIP_Real value = 0.0;
+                for (uint32_t s = 0; s < n; ++s)
+                {
+                    value += (segment >> s & 1) * weights[s];
+                }
+                best = std::min(best, value);
+            }
+        }
+
+        bool solved = solver.solve(root, 0.0, 1000000, 1e-9);
+        if (!solved || !(solver.getBestValue() == best || std::abs(solver.getBestValue() - best) < 1e-9))
+        {
+            ++mismatches;
+        }
+    }
+    return mismatches;
+}
+
+/**
+ * Measures the construction of the superpixel graph on a synthetic label image of size `width` x `height`
+ * with irregular superpixels of roughly `size` x `size` pixels
+ */
+void benchSyntheticGraph(uint32_t width, uint32_t height, uint32_t size, size_t repetitions)
+{
+    uint32_t columns = (width + size - 1) / size;
+    uint32_t rows = (height + size - 1) / size;
+    size_t superpixelcount = columns * rows;
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> jitter(-2, 2);
+    std::vector<uint32_t> segmentation(size_t(width) * height);
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            // move the borders a little, so that the superpixels are not rectangular
+            int64_t xx = std::min<int64_t>(std::max<int64_t>(int64_t(x) + jitter(rng), 0), width - 1);
+            int64_t yy = std::min<int64_t>(std::max<int64_t>(int64_t(y) + jitter(rng), 0), height - 1);
+            segmentation[x + size_t(y) * width] = (yy / size) * columns + xx / size;
+        }
+    }
+    std::vector<double> colors(superpixelcount, 0.0);
+
+    beginInput("synthetic " + std::to_string(width) + "x" + std::to_string(height), superpixelcount);
+    measure("graph construction (1 thread)", repetitions, [&](size_t) {
+        buildSuperpixelGraph(&segmentation[0], width, height, superpixelcount, colors, 1);
+    });
+    measure("graph construction (all threads)", repetitions, [&](size_t) {
+        buildSuperpixelGraph(&segmentation[0], width, height, superpixelcount, colors, 0);
+    });
+}
+
+
+/**
+ * Measures the pricing heuristic, combinatorial and exact pricing solves and the separation of connectivity cuts
+ * The master problem is only transformed, not solved. Instead of the duals of a master LP, every superpixel
+ * is given the dual value \f$\mu_s = \max(0, 32 - \min_{t\in T}|y_t-y_s|)\f$, so that segments of superpixels
+ * with similar colors have negative reduced costs, as in the first pricing rounds.
+ * The optimal values of the combinatorial pricing are checked against the pricing SCIP.
+ */
+SCIP_RETCODE benchPricing(Graph& g, const std::vector<Graph::vertex_descriptor>& master_nodes, size_t repetitions)
+{
+    CsrGraph csr(g);
+    SCIP* scip;
+    SCIP_CALL(SCIPcreate(&scip));
+    SCIP_CALL(SCIPincludeDefaultPlugins(scip));
+    SCIPsetMessagehdlrQuiet(scip, TRUE);
+    RunStats stats;
+    SegmentPricer* pricer;
+    SCIP_CALL(createMasterProblem(scip, g, csr, master_nodes, initialSegments(master_nodes, csr.numVertices()), SolverOptions(), stats, &pricer));
+    SCIP_CALL(SCIPtransformProb(scip)); // initializes the pricer
+
+    std::vector<SCIP_Real> mu(csr.numVertices());
+    for (size_t s = 0; s < csr.numVertices(); ++s)
+    {
+        SCIP_Real distance = SCIPinfinity(scip);
+        for (auto t : master_nodes)
+        {
+            distance = std::min(distance, std::abs(csr.color(t) - csr.color(s)));
+        }
+        mu[s] = std::max(0.0, 32.0 - distance);
+    }
+    pricer->setDuals(mu);
+    SCIP_Real lambda = 0.0;
+
+    size_t num_superpixels = 0;
+    measure("SegmentPricer::heuristic", repetitions * master_nodes.size(), [&](size_t i) {
+        num_superpixels += pricer->heuristic(scip, master_nodes[i % master_nodes.size()], lambda).second.size();
+    });
+
+    size_t solved = 0;
+    std::vector<SCIP_Real> combinatorial_bounds(master_nodes.size(), SCIPinfinity(scip));
+    std::vector<bool> combinatorial_solved(master_nodes.size());
+    measure("combinatorial pricing solve", master_nodes.size(), [&](size_t i) {
+        combinatorial_solved[i] = pricer->solveCombinatorially(scip, i, lambda);
+        solved += combinatorial_solved[i];
+        combinatorial_bounds[i] = pricer->getLowerBound(i);
+    });
+    if (solved < master_nodes.size())
+    {
+        std::cout << "combinatorial pricing reached the node limit for " << master_nodes.size() - solved << " master nodes" << std::endl;
+    }
+
+    SCIP_RETCODE retcode = SCIP_OKAY;
+    measure("exact pricing solve", master_nodes.size(), [&](size_t i) {
+        if (retcode == SCIP_OKAY)
+        {
+            retcode = pricer->solveExactly(scip, i, lambda);
+        }
+    });
+    SCIP_CALL(retcode);
+    for (size_t i = 0; i < master_nodes.size(); ++i)
+    {
+        // with the cutoff, the pricing SCIP only proves that no segment has negative reduced costs
+        if (combinatorial_solved[i]
+            && !SCIPisFeasEQ(scip, std::min(0.0, combinatorial_bounds[i]), std::min(0.0, pricer->getLowerBound(i))))
+        {
+            ++check_failures;
+            std::cerr << "  combinatorial pricing of master node " << master_nodes[i] << " found " << combinatorial_bounds[i]
+                << ", the pricing SCIP found " << pricer->getLowerBound(i) << std::endl;
+        }
+    }
+
+    size_t sepa_calls = 0;
+    double sepa_time = 0.0;
+    for (size_t i = 0; i < master_nodes.size(); ++i)
+    {
+        auto conshdlr = static_cast<ConnectivityCons*>(SCIPfindObjConshdlr(pricer->getPricingSCIP(i), "connectivity"));
+        sepa_calls += conshdlr->getSepaCalls();
+        sepa_time += conshdlr->getSepaTime();
+    }
+    if (sepa_calls > 0)
+    {
+        record("ConnectivityCons::sepaConnectivity", sepa_calls, 1e6 * sepa_time / sepa_calls);
+    }
+
+    SCIP_CALL(SCIPfree(&scip));
+    return SCIP_OKAY;
+}
+
+/**
+ * Runs the benchmarks of all stages on one of the bundled images
+ */
+SCIP_RETCODE benchImage(const std::string& filename, const std::string& seeds_filename, int n, size_t repetitions,
+    const std::string& output_prefix)
+{
+    unsigned int width, height;
+    std::vector<uint8_t> gray;
+    std::vector<float> normalized;
+    std::vector<uint32_t> segmentation;
+    Image::load(filename, width, height, gray, normalized);
+    unsigned int superpixelcount = Image::slic(normalized, width, height, n, segmentation);
+
+    beginInput(filename, superpixelcount);
+    measure("Image::load", 10, [&](size_t) {
+        Image::load(filename, width, height, gray, normalized);
+    });
+    measure("vl_slic_segment", 3, [&](size_t) {
+        Image::slic(normalized, width, height, n, segmentation);
+    });
+
+    Image image(filename, n, output_prefix);
+    measure("Image::graph (1 thread)", 20, [&](size_t) {
+        image.graph(1);
+    });
+    measure("Image::graph (all threads)", 20, [&](size_t) {
+        image.graph();
+    });
+    Graph g = image.graph();
+    benchConnectivity(g, repetitions);
+
+    Seeds seeds;
+    std::vector<Graph::vertex_descriptor> master_nodes;
+    if (!readSeedsFile(seeds_filename, seeds) || !masterNodesFromSeeds(seeds, image, master_nodes) || master_nodes.empty())
+    {
+        return SCIP_READERROR;
+    }
+    SCIP_CALL(benchPricing(g, master_nodes, 10));
+
+    std::vector<std::vector<Graph::vertex_descriptor>> segments;
+    for (auto& segment : initialSegments(master_nodes, num_vertices(g)))
+    {
+        segments.push_back(std::vector<Graph::vertex_descriptor>(segment.begin(), segment.end()));
+    }
+    measure("Image::writeSegments (1 thread)", 5, [&](size_t) {
+        image.writeSegments(master_nodes, segments, g, 1);
+    });
+    measure("Image::writeSegments (all threads)", 5, [&](size_t) {
+        image.writeSegments(master_nodes, segments, g);
+    });
+    return SCIP_OKAY;
+}
+
+/**
+ * Runs the benchmarks on the bundled images at several numbers of superpixels
+ * Usage: `fopra_bench [--json FILE] [--repetitions N] [--output PREFIX]`, where N is the number of repetitions
+ * of the connectivity benchmarks. The rendered images are written to files starting with PREFIX,
+ * by default `fopra_bench_` in the temporary directory.
+ */
+int main(int argc, char** argv)
+{
+    std::vector<std::string> images = {"input1.png", "input2.png", "input3.png", "input4.png"};
+    std::vector<int> superpixel_counts = {50, 200, 800};
+    size_t repetitions = 1000;
+    std::string json;
+    const char* tmpdir = std::getenv("TMPDIR");
+    std::string output_prefix = std::string(tmpdir != NULL && *tmpdir != '\0' ? tmpdir : "/tmp") + "/fopra_bench_";
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string option = argv[i];
+        if (option == "--json")
+        {
+            json = argv[i + 1];
+        }
+        else if (option == "--repetitions")
+        {
+            repetitions = std::stoul(argv[i + 1]);
+        }
+        else if (option == "--output")
+        {
+            output_prefix = argv[i + 1];
+        }
+    }
+
+    size_t mismatches = checkSubgraphSolver(1000);
+    std::cout << "combinatorial pricing: " << mismatches << " mismatches with the exhaustive enumeration" << std::endl;
+    check_failures += mismatches;
+
+    for (auto& filename : images)
+    {
+        std::string seeds_filename = filename.substr(0, filename.size() - 4) + "seeds.txt";
+        for (int count : superpixel_counts)
+        {
+            SCIP_RETCODE retcode = benchImage(filename, seeds_filename, count, repetitions, output_prefix);
+            if (retcode != SCIP_OKAY)
+            {
+                SCIPprintError(retcode);
+                return 1;
+            }
+        }
+    }
+    benchSyntheticGraph(4000, 3000, 110, 3); // 12 megapixels
+
+    if (!json.empty() && !writeJson(json))
+    {
+        return 1;
+    }
+    if (check_failures > 0)
+    {
+        std::cerr << check_failures << " checks of the combinatorial pricing failed" << std::endl;
+        return 1;
+    }
+    return 0;
+}
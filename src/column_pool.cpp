@@ -0,0 +1,59 @@
+#include <algorithm>
+#include <boost/functional/hash.hpp>
+#include "column_pool.h"
+
+size_t ColumnPool::hash(const uint32_t* first, const uint32_t* last)
+{
+    return boost::hash_range(first, last);
+}
+
+size_t ColumnPool::find(const std::vector<uint32_t>& segment) const
+{
+    const uint32_t* first = segment.data();
+    const uint32_t* last = segment.data() + segment.size();
+    auto range = by_hash.equal_range(hash(first, last));
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        size_t column = it->second;
+        if (size_t(end(column) - begin(column)) == segment.size() && std::equal(first, last, begin(column)))
+        {
+            return column;
+        }
+    }
+    return NOT_FOUND;
+}
+
+size_t ColumnPool::add(uint32_t master_node, const std::vector<uint32_t>& segment, SCIP_Real cost)
+{
+    if (find(segment) != NOT_FOUND)
+    {
+        return NOT_FOUND;
+    }
+    size_t column = size();
+    superpixels.insert(superpixels.end(), segment.begin(), segment.end());
+    offsets.push_back(superpixels.size());
+    master_nodes.push_back(master_node);
+    costs.push_back(cost);
+    by_hash.insert(std::make_pair(hash(begin(column), end(column)), column));
+    return column;
+}
+
+bool ColumnPool::contains(size_t column, uint32_t s) const
+{
+    return std::binary_search(begin(column), end(column), s);
+}
+
+void ColumnPool::reducedCosts(const SCIP_Real* mu, SCIP_Real lambda, SCIP_Real* redcosts) const
+{
+    const uint32_t* s = superpixels.data();
+    for (size_t column = 0; column < size(); ++column)
+    {
+        const uint32_t* last = superpixels.data() + offsets[column + 1];
+        SCIP_Real redcost = costs[column] - lambda;
+        for (; s != last; ++s)
+        {
+            redcost -= mu[*s];
+        }
+        redcosts[column] = redcost;
+    }
+}
@@ -0,0 +1,103 @@
+#ifndef COLUMN_POOL_H
+#define COLUMN_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <scip/scip.h>
+
+/**
+ * All segments added to the master problem
+ * The superpixels of each segment are stored as a sorted span in one flat array, together with the master node
+ * and the costs of the segment. A hash of the superpixels allows to reject a segment that has been added before
+ * in expected constant time, and membership tests and iteration work on the spans without copying.
+ *
+ * The pool is only modified by the pricer while adding columns, which happens sequentially.
+ */
+class ColumnPool
+{
+public:
+    enum : size_t
+    {
+        NOT_FOUND = SIZE_MAX
+    };
+
+    /**
+     * Adds a segment unless an equal one is already contained in the pool
+     * @return the index of the new segment, or `NOT_FOUND` if it is a duplicate
+     */
+    size_t add(
+        uint32_t master_node, ///< the master node of the segment
+        const std::vector<uint32_t>& superpixels, ///< the superpixels of the segment, sorted
+        SCIP_Real cost ///< objective coefficient of the segment in the master problem
+        );
+
+    /**
+     * @return the index of the segment consisting of the sorted `superpixels`, or `NOT_FOUND`
+     */
+    size_t find(const std::vector<uint32_t>& superpixels) const;
+
+    /**
+     * @return the number of segments
+     */
+    size_t size() const
+    {
+        return costs.size();
+    }
+
+    /**
+     * Computes the reduced costs \f$c_P - \sum_{s\in P}\mu_s - \lambda\f$ of all segments
+     * The superpixels of all segments are traversed in a single pass over the flat array.
+     */
+    void reducedCosts(
+        const SCIP_Real* mu, ///< dual values \f$\mu_s\f$ of the partitioning constraints, indexed by superpixel
+        SCIP_Real lambda, ///< dual value of the constraint on the number of segments
+        SCIP_Real* redcosts ///< array of length `size()` the reduced costs are written to
+        ) const;
+
+    /**
+     * @return whether segment `column` contains superpixel `s`
+     */
+    bool contains(size_t column, uint32_t s) const;
+
+    /**
+     * @return pointer to the first superpixel of segment `column`, valid until the next call of `add`
+     */
+    const uint32_t* begin(size_t column) const
+    {
+        return superpixels.data() + offsets[column];
+    }
+
+    /**
+     * @return pointer past the last superpixel of segment `column`
+     */
+    const uint32_t* end(size_t column) const
+    {
+        return superpixels.data() + offsets[column + 1];
+    }
+
+    uint32_t masterNode(size_t column) const
+    {
+        return master_nodes[column];
+    }
+
+    SCIP_Real cost(size_t column) const
+    {
+        return costs[column];
+    }
+
+private:
+    /**
+     * @return a hash of the sorted superpixels in `[first, last)`
+     */
+    static size_t hash(const uint32_t* first, const uint32_t* last);
+
+    std::vector<uint32_t> superpixels; ///< the superpixels of all segments, segment c occupies `offsets[c]`, ..., `offsets[c+1]-1`
+    std::vector<size_t> offsets = std::vector<size_t>(1, 0);
+    std::vector<uint32_t> master_nodes;
+    std::vector<SCIP_Real> costs;
+    std::unordered_multimap<size_t, size_t> by_hash; ///< hash of the superpixels to index of the segment
+};
+
+#endif
@@ -0,0 +1,320 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "connected_subgraph_solver.h"
+
+ConnectedSubgraphSolver::ConnectedSubgraphSolver(const CsrGraph& g_) :
+    g(g_), offset(0.0), feasible_limit(0.0), stamp(0), cluster_stamp(0), value(0.0), best_value(0.0), threshold(0.0), epsilon(0.0), num_nodes(0), node_limit(0)
+{
+    size_t n = g.numVertices();
+    weights.assign(n, 0.0);
+    initial_state.assign(n, FREE);
+    state.resize(n);
+    members.reserve(n);
+    mark.resize(n);
+    queue.resize(n);
+    cluster.resize(n);
+    cluster_profit.reserve(n);
+    cluster_gain.reserve(n);
+    cluster_mark.resize(n);
+    distance.resize(n);
+    origin.resize(n);
+    heap.reserve(n);
+}
+
+void ConnectedSubgraphSolver::findClusters()
+{
+    // connected components of free superpixels with negative weight
+    size_t n = g.numVertices();
+    const uint32_t none = UINT32_MAX;
+    std::fill(cluster.begin(), cluster.end(), none);
+    cluster_profit.clear();
+    for (size_t s = 0; s < n; ++s)
+    {
+        if (state[s] != FREE || weights[s] >= 0.0 || cluster[s] != none)
+        {
+            continue;
+        }
+        uint32_t id = cluster_profit.size();
+        SCIP_Real profit = 0.0;
+        size_t head = 0;
+        size_t tail = 0;
+        cluster[s] = id;
+        queue[tail++] = s;
+        while (head < tail)
+        {
+            uint32_t v = queue[head++];
+            profit += weights[v];
+            for (const uint32_t* w = g.neighboursBegin(v); w != g.neighboursEnd(v); ++w)
+            {
+                if (state[*w] == FREE && weights[*w] < 0.0 && cluster[*w] == none)
+                {
+                    cluster[*w] = id;
+                    queue[tail++] = *w;
+                }
+            }
+        }
+        cluster_profit.push_back(profit);
+    }
+    cluster_gain = cluster_profit;
+
+    // a segment containing a cluster not adjacent to the root contains a positive neighbour of the cluster,
+    // whose weight is shared among all clusters adjacent to it
+    std::vector<SCIP_Real> share(cluster_gain.size(), std::numeric_limits<SCIP_Real>::infinity());
+    std::fill(cluster_mark.begin(), cluster_mark.end(), 0);
+    uint32_t visit = 0;
+    for (size_t v = 0; v < n; ++v)
+    {
+        if (state[v] != FREE || weights[v] < 0.0)
+        {
+            continue;
+        }
+        ++visit;
+        size_t adjacent_clusters = 0;
+        for (const uint32_t* w = g.neighboursBegin(v); w != g.neighboursEnd(v); ++w)
+        {
+            if (cluster[*w] != none && cluster_mark[cluster[*w]] != visit)
+            {
+                cluster_mark[cluster[*w]] = visit;
+                ++adjacent_clusters;
+            }
+        }
+        ++visit;
+        for (const uint32_t* w = g.neighboursBegin(v); w != g.neighboursEnd(v); ++w)
+        {
+            if (cluster[*w] != none && cluster_mark[cluster[*w]] != visit)
+            {
+                cluster_mark[cluster[*w]] = visit;
+                share[cluster[*w]] = std::min(share[cluster[*w]], weights[v] / adjacent_clusters);
+            }
+        }
+    }
+    for (size_t id = 0; id < cluster_gain.size(); ++id)
+    {
+        cluster_gain[id] = std::min(0.0, cluster_gain[id] + share[id]);
+    }
+    std::fill(cluster_mark.begin(), cluster_mark.end(), 0);
+    cluster_stamp = 0;
+}
+
+bool ConnectedSubgraphSolver::solve(size_t root, SCIP_Real threshold_, size_t node_limit_, SCIP_Real epsilon_)
+{
+    state = initial_state;
+    for (auto s : excluded)
+    {
+        state[s] = EXCLUDED;
+    }
+    std::fill(mark.begin(), mark.end(), 0);
+    stamp = 0;
+    members.clear();
+    solutions.clear();
+    node_limit = node_limit_;
+    epsilon = epsilon_;
+    num_nodes = 0;
+
+    // every segment containing all required superpixels has a value below the limit, every other one a value above it
+    SCIP_Real total = 1.0;
+    for (auto w : weights)
+    {
+        total += std::abs(w);
+    }
+    SCIP_Real bonus = 2.0 * total;
+    std::vector<SCIP_Real> original;
+    for (auto s : required)
+    {
+        original.push_back(weights[s]);
+        weights[s] -= bonus;
+    }
+    offset = bonus * required.size();
+    feasible_limit = total - offset;
+    threshold = std::min(threshold_ - offset, feasible_limit);
+
+    state[root] = INCLUDED;
+    members.push_back(root);
+    value = weights[root];
+    best_value = value;
+    findClusters();
+    if (value < threshold)
+    {
+        solutions.push_back(Solution{value + offset, members});
+    }
+    bool complete = search(0);
+
+    for (size_t k = 0; k < required.size(); ++k)
+    {
+        weights[required[k]] = original[k];
+    }
+    if (best_value < feasible_limit)
+    {
+        best_value += offset;
+    }
+    else
+    {
+        best_value = std::numeric_limits<SCIP_Real>::infinity();
+    }
+    excluded.clear();
+    required.clear();
+    return complete;
+}
+
+bool ConnectedSubgraphSolver::search(size_t first_new)
+{
+    if (++num_nodes > node_limit)
+    {
+        return false;
+    }
+    size_t num_members = members.size();
+    SCIP_Real node_value = value;
+
+    // absorb all free superpixels with non-positive weight reachable through such superpixels
+    for (size_t k = first_new; k < members.size(); ++k)
+    {
+        uint32_t v = members[k];
+        for (const uint32_t* w = g.neighboursBegin(v); w != g.neighboursEnd(v); ++w)
+        {
+            if (state[*w] == FREE && weights[*w] <= 0.0)
+            {
+                state[*w] = INCLUDED;
+                members.push_back(*w);
+                value += weights[*w];
+            }
+        }
+    }
+    if (value < best_value - epsilon)
+    {
+        best_value = value;
+        if (value < threshold)
+        {
+            solutions.push_back(Solution{value + offset, members});
+        }
+    }
+
+    // bound the gain of every component of free superpixels adjacent to the segment
+    SCIP_Real bound = value;
+    uint32_t branch_vertex = 0;
+    SCIP_Real branch_gain = 0.0;
+    ++stamp;
+    for (size_t k = 0; k < members.size(); ++k)
+    {
+        uint32_t m = members[k];
+        for (const uint32_t* start = g.neighboursBegin(m); start != g.neighboursEnd(m); ++start)
+        {
+            if (state[*start] != FREE || mark[*start] == stamp)
+            {
+                continue;
+            }
+            SCIP_Real shared = 0.0;
+            ++cluster_stamp;
+            size_t head = 0;
+            size_t tail = 0;
+            mark[*start] = stamp;
+            queue[tail++] = *start;
+            heap.clear();
+            while (head < tail)
+            {
+                uint32_t v = queue[head++];
+                if (weights[v] < 0.0 && cluster_mark[cluster[v]] != cluster_stamp)
+                {
+                    cluster_mark[cluster[v]] = cluster_stamp;
+                    shared += cluster_gain[cluster[v]];
+                }
+                bool adjacent = false;
+                for (const uint32_t* w = g.neighboursBegin(v); w != g.neighboursEnd(v); ++w)
+                {
+                    if (state[*w] == INCLUDED)
+                    {
+                        adjacent = true;
+                    }
+                    else if (state[*w] == FREE && mark[*w] != stamp)
+                    {
+                        mark[*w] = stamp;
+                        queue[tail++] = *w;
+                    }
+                }
+                distance[v] = std::numeric_limits<SCIP_Real>::infinity();
+                if (adjacent)
+                {
+                    distance[v] = std::max(0.0, weights[v]);
+                    origin[v] = v;
+                    heap.push_back(HeapEntry(distance[v], v));
+                }
+            }
+
+            // the clusters in the order of their distance from the segment, where the distance of a superpixel
+            // is the weight of the cheapest path of free superpixels from the segment to it
+            std::make_heap(heap.begin(), heap.end(), std::greater<HeapEntry>());
+            ++cluster_stamp;
+            SCIP_Real profit = 0.0;
+            SCIP_Real gain = 0.0;
+            uint32_t entry = *start;
+            while (!heap.empty())
+            {
+                std::pop_heap(heap.begin(), heap.end(), std::greater<HeapEntry>());
+                HeapEntry top = heap.back();
+                heap.pop_back();
+                uint32_t v = top.second;
+                if (top.first > distance[v])
+                {
+                    continue;
+                }
+                if (weights[v] < 0.0 && cluster_mark[cluster[v]] != cluster_stamp)
+                {
+                    // connecting the clusters up to this one costs at least the distance to this one
+                    cluster_mark[cluster[v]] = cluster_stamp;
+                    profit += cluster_profit[cluster[v]];
+                    if (distance[v] + profit < gain)
+                    {
+                        gain = distance[v] + profit;
+                        entry = origin[v];
+                    }
+                }
+                for (const uint32_t* w = g.neighboursBegin(v); w != g.neighboursEnd(v); ++w)
+                {
+                    SCIP_Real d = distance[v] + std::max(0.0, weights[*w]);
+                    if (state[*w] == FREE && d < distance[*w])
+                    {
+                        distance[*w] = d;
+                        origin[*w] = origin[v];
+                        heap.push_back(HeapEntry(d, *w));
+                        std::push_heap(heap.begin(), heap.end(), std::greater<HeapEntry>());
+                    }
+                }
+            }
+            gain = std::max(gain, shared);
+            bound += gain;
+            if (gain < branch_gain)
+            {
+                branch_gain = gain;
+                branch_vertex = entry;
+            }
+        }
+    }
+
+    bool complete = true;
+    if (branch_gain < 0.0 && bound < best_value - epsilon)
+    {
+        // add the entry to the segment first, this leads to good segments early
+        state[branch_vertex] = INCLUDED;
+        members.push_back(branch_vertex);
+        SCIP_Real branch_value = value;
+        value += weights[branch_vertex];
+        complete = search(members.size() - 1);
+        members.pop_back();
+        value = branch_value;
+
+        if (complete)
+        {
+            state[branch_vertex] = EXCLUDED;
+            complete = search(members.size());
+        }
+        state[branch_vertex] = FREE;
+    }
+
+    while (members.size() > num_members)
+    {
+        state[members.back()] = FREE;
+        members.pop_back();
+    }
+    value = node_value;
+    return complete;
+}
@@ -0,0 +1,170 @@
+#ifndef CONNECTED_SUBGRAPH_SOLVER_H
+#define CONNECTED_SUBGRAPH_SOLVER_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <scip/scip.h>
+#include "csr_graph.h"
+
+/**
+ * Exact combinatorial solver of the pricing problem
+ * Given weights \f$w_s\f$ of the superpixels, it finds a connected segment \f$P\f$ containing the root \f$t\f$
+ * that minimizes \f$\sum_{s\in P}w_s\f$, working on the graph of superpixels directly.
+ *
+ * The solver is a depth-first branch-and-bound. Every node of the search tree holds a connected segment \f$S\f$
+ * and a set of excluded superpixels.
+ * - Reduction: a superpixel with \f$w_s\leq 0\f$ adjacent to \f$S\f$ can always be added, so all of them
+ *   are absorbed into \f$S\f$ before branching. Afterwards, every free superpixel adjacent to \f$S\f$ has positive weight.
+ * - Bounding: the free superpixels reachable from \f$S\f$ fall into components that only touch each other through \f$S\f$.
+ *   Within a component, the clusters (connected sets of superpixels with negative weight) are sorted by the weight
+ *   \f$d_N\f$ of the cheapest path of positive superpixels from \f$S\f$. A segment using the clusters \f$N_1, \dots, N_k\f$
+ *   contains such a path to each of them, so it gains at least \f$\min(0, \min_k(d_{N_k} + \sum_{j\leq k}w(N_j)))\f$ from the component.
+ *   Alternatively, each cluster not adjacent to \f$S\f$ needs a positive neighbour in the segment. Sharing the weight of a positive
+ *   superpixel equally among its adjacent clusters yields a second bound, and the larger one is used.
+ * - Branching: in the component with the largest potential gain, the first superpixel on the cheapest path to the cluster
+ *   attaining the bound is either added to \f$S\f$ or excluded.
+ *
+ * Required superpixels get a bonus \f$M\f$ larger than twice the total absolute weight, so that every segment containing
+ * all of them is better than any segment missing one, and the bounds above need no special treatment.
+ *
+ * The segment, the clusters and the heap of the shortest path search are members reused by every call of `solve`.
+ * The search stops after a given number of nodes, so that the caller can fall back to another method on hard instances.
+ */
+class ConnectedSubgraphSolver
+{
+public:
+    /**
+     * Segment found during the search
+     */
+    struct Solution
+    {
+        SCIP_Real value; ///< \f$\sum_{s\in P}w_s\f$
+        std::vector<uint32_t> superpixels; ///< the superpixels of the segment, the root first
+    };
+
+    ConnectedSubgraphSolver(
+        const CsrGraph& g ///< the graph of superpixels
+        );
+
+    /**
+     * Sets the weight \f$w_s\f$ of superpixel `s`
+     */
+    void setWeight(size_t s, SCIP_Real weight)
+    {
+        weights[s] = weight;
+    }
+
+    /**
+     * Excludes superpixel `s` from all segments
+     */
+    void forbid(size_t s)
+    {
+        initial_state[s] = EXCLUDED;
+    }
+
+    /**
+     * Excludes superpixel `s` from all segments of the next call of `solve`
+     */
+    void exclude(size_t s)
+    {
+        excluded.push_back(s);
+    }
+
+    /**
+     * Requires superpixel `s` to be contained in all segments of the next call of `solve`
+     */
+    void require(size_t s)
+    {
+        required.push_back(s);
+    }
+
+    /**
+     * Finds a minimum weight connected segment containing `root`
+     * @return false if the node limit was reached before the optimality of the best segment was proven
+     */
+    bool solve(
+        size_t root, ///< the superpixel every segment contains, must not be forbidden
+        SCIP_Real threshold, ///< every improving segment found whose value is below the threshold is stored in `getSolutions()`
+        size_t node_limit, ///< maximum number of nodes of the search tree
+        SCIP_Real epsilon ///< a segment is only considered an improvement if it is better by more than this
+        );
+
+    /**
+     * @return the value of the best segment found by the last call of `solve`,
+     * infinity if no segment contains all required superpixels
+     */
+    SCIP_Real getBestValue() const
+    {
+        return best_value;
+    }
+
+    /**
+     * @return the segments with values below the threshold found by the last call of `solve`, in the order they were found,
+     * so the best one is last
+     */
+    const std::vector<Solution>& getSolutions() const
+    {
+        return solutions;
+    }
+
+    /**
+     * @return the number of nodes of the search tree of the last call of `solve`
+     */
+    size_t getNumNodes() const
+    {
+        return num_nodes;
+    }
+
+private:
+    enum State : uint8_t
+    {
+        FREE,
+        INCLUDED,
+        EXCLUDED
+    };
+
+    /**
+     * Processes a node of the search tree
+     * The members of the segment starting at `members[first_new]` have not yet been checked for superpixels to absorb.
+     * @return false if the node limit was reached
+     */
+    bool search(size_t first_new);
+
+    /**
+     * Computes the clusters of the free superpixels and a bound on the gain of each cluster
+     */
+    void findClusters();
+
+    const CsrGraph& g;
+    std::vector<SCIP_Real> weights;
+    std::vector<State> initial_state; ///< `EXCLUDED` for forbidden superpixels, `FREE` otherwise
+    std::vector<uint32_t> excluded; ///< superpixels excluded in the next call of `solve` only
+    std::vector<uint32_t> required; ///< superpixels required in the next call of `solve` only
+    SCIP_Real offset; ///< the true value of a segment is its value for the modified weights plus this
+    SCIP_Real feasible_limit; ///< a segment contains all required superpixels iff its value is below this
+    std::vector<State> state;
+    std::vector<uint32_t> members; ///< the superpixels of the current segment \f$S\f$ in the order they were added
+    std::vector<uint32_t> mark; ///< component bounding: a superpixel is visited iff its mark equals `stamp`
+    uint32_t stamp;
+    std::vector<uint32_t> queue;
+    typedef std::pair<SCIP_Real, uint32_t> HeapEntry; ///< pair<distance, superpixel>
+    std::vector<HeapEntry> heap; ///< priority queue of the shortest path search, the closest superpixel on top
+    std::vector<SCIP_Real> distance; ///< weight of the cheapest path from the segment to each superpixel of the current component
+    std::vector<uint32_t> origin; ///< superpixel adjacent to the segment where the cheapest path to each superpixel starts
+    std::vector<uint32_t> cluster; ///< index of the cluster of each free superpixel with negative weight
+    std::vector<SCIP_Real> cluster_profit; ///< sum of the weights of the superpixels of each cluster
+    std::vector<SCIP_Real> cluster_gain; ///< lower bound on the change of the segment value by using a cluster
+    std::vector<uint32_t> cluster_mark; ///< a cluster is counted in the current bound iff its mark equals `cluster_stamp`
+    uint32_t cluster_stamp;
+
+    SCIP_Real value; ///< \f$\sum_{s\in S}w_s\f$
+    SCIP_Real best_value;
+    SCIP_Real threshold;
+    SCIP_Real epsilon;
+    size_t num_nodes;
+    size_t node_limit;
+    std::vector<Solution> solutions;
+};
+
+#endif
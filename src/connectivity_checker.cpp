@@ -0,0 +1,78 @@
+#include <algorithm>
+#include "connectivity_checker.h"
+
+ConnectivityChecker::ConnectivityChecker(const CsrGraph& g_) :
+    g(g_), num_components(0), current_stamp(0)
+{
+    size_t n = g.numVertices();
+    component.assign(n, UNSELECTED);
+    order.resize(n);
+    component_start.resize(n + 1);
+    boundary.resize(n);
+    stamp.assign(n, 0);
+}
+
+size_t ConnectivityChecker::findComponents()
+{
+    size_t n = component.size();
+    for (size_t s = 0; s < n; ++s)
+    {
+        if (component[s] != UNSELECTED)
+        {
+            component[s] = UNVISITED;
+        }
+    }
+
+    num_components = 0;
+    size_t end = 0; // end of the BFS queue in `order`
+    for (size_t s = 0; s < n; ++s)
+    {
+        if (component[s] != UNVISITED)
+        {
+            continue;
+        }
+        // breadth-first search starting at s; the queue directly forms the component in `order`
+        component_start[num_components] = end;
+        component[s] = num_components;
+        order[end++] = s;
+        for (size_t head = component_start[num_components]; head < end; ++head)
+        {
+            uint32_t u = order[head];
+            for (const uint32_t* v = g.neighboursBegin(u); v != g.neighboursEnd(u); ++v)
+            {
+                if (component[*v] == UNVISITED)
+                {
+                    component[*v] = num_components;
+                    order[end++] = *v;
+                }
+            }
+        }
+        ++num_components;
+    }
+    component_start[num_components] = end;
+    return num_components;
+}
+
+size_t ConnectivityChecker::findBoundary(size_t c)
+{
+    if (++current_stamp == 0)
+    {
+        // the stamps wrapped around, so they have to be reset
+        std::fill(stamp.begin(), stamp.end(), 0);
+        current_stamp = 1;
+    }
+    size_t size = 0;
+    for (const uint32_t* s = componentBegin(c); s != componentEnd(c); ++s)
+    {
+        for (const uint32_t* v = g.neighboursBegin(*s); v != g.neighboursEnd(*s); ++v)
+        {
+            // every superpixel adjacent to the component that is not in it is unselected
+            if (component[*v] != static_cast<int32_t>(c) && stamp[*v] != current_stamp)
+            {
+                stamp[*v] = current_stamp;
+                boundary[size++] = *v;
+            }
+        }
+    }
+    return size;
+}
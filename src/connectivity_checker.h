@@ -0,0 +1,106 @@
+#ifndef CONNECTIVITY_CHECKER_H
+#define CONNECTIVITY_CHECKER_H
+
+#include <cstdint>
+#include <vector>
+#include "csr_graph.h"
+
+/**
+ * Computes connected components of induced subgraphs of the superpixel graph
+ * The adjacency is read from the flat arrays of a CsrGraph. The boundaries are deduplicated with stamps,
+ * so that the per-superpixel arrays never have to be cleared between calls.
+ * This makes the checker cheap enough to be used in every separation, enforcement and check call of ConnectivityCons.
+ */
+class ConnectivityChecker
+{
+public:
+    ConnectivityChecker(
+        const CsrGraph& g ///< the graph of superpixels
+        );
+
+    /**
+     * Marks the superpixel `s` as (not) contained in the subgraph
+     */
+    void select(size_t s, bool selected)
+    {
+        component[s] = selected ? UNVISITED : UNSELECTED;
+    }
+
+    /**
+     * @return whether the superpixel `s` is contained in the subgraph
+     */
+    bool isSelected(size_t s) const
+    {
+        return component[s] != UNSELECTED;
+    }
+
+    /**
+     * Finds all connected components of the subgraph induced by the selected superpixels using breadth-first search
+     * @return the number of connected components
+     */
+    size_t findComponents();
+
+    /**
+     * @return the index of the connected component containing the selected superpixel `s`
+     */
+    int32_t componentOf(size_t s) const
+    {
+        return component[s];
+    }
+
+    /**
+     * @return pointer to the first superpixel of component `c`, the superpixels of a component are stored contiguously
+     */
+    const uint32_t* componentBegin(size_t c) const
+    {
+        return &order[0] + component_start[c];
+    }
+
+    /**
+     * @return pointer past the last superpixel of component `c`
+     */
+    const uint32_t* componentEnd(size_t c) const
+    {
+        return &order[0] + component_start[c + 1];
+    }
+
+    /**
+     * Collects all superpixels that are adjacent to component `c` but not contained in it, i.e. \f$\delta(C)\f$
+     * The result is valid until the next call of this method.
+     * @return the number of superpixels in the boundary, which are stored starting at `boundaryBegin()`
+     */
+    size_t findBoundary(size_t c);
+
+    const uint32_t* boundaryBegin() const
+    {
+        return &boundary[0];
+    }
+
+    /**
+     * @return the number of superpixels in the graph
+     */
+    size_t size() const
+    {
+        return component.size();
+    }
+
+private:
+    enum : int32_t
+    {
+        UNSELECTED = -2, ///< the superpixel is not contained in the subgraph
+        UNVISITED = -1 ///< the superpixel is selected, but has not been assigned a component yet
+    };
+
+    const CsrGraph& g;
+
+    std::vector<int32_t> component; ///< component index of each superpixel, or `UNSELECTED`/`UNVISITED`
+    std::vector<uint32_t> order; ///< selected superpixels ordered by component, also used as BFS queue
+    std::vector<uint32_t> component_start; ///< component c occupies `order[component_start[c]]`, ..., `order[component_start[c+1]-1]`
+    size_t num_components;
+
+    std::vector<uint32_t> boundary;
+    std::vector<uint32_t> stamp; ///< `stamp[s] == current_stamp` iff s has already been added to the boundary
+    uint32_t current_stamp;
+};
+
+#endif
@@ -1,19 +1,28 @@
-#include <boost/graph/connected_components.hpp>
+#include <algorithm>
+#include <chrono>
 #include "connectivity_cons.h"
 #include "graph.h"
 
 ConnectivityCons::ConnectivityCons(
     SCIP* scip,
-    Graph& g_,
-    std::vector<Graph::vertex_descriptor>& master_nodes_,
+    const CsrGraph& g_,
+    const dynamic_bitset<>& master_mask_,
     Graph::vertex_descriptor master_node_,
-    std::vector<SCIP_VAR*>& superpixel_vars_
+    std::vector<SCIP_VAR*>& superpixel_vars_,
+    const CutPool& pool_
     ) :
     ObjConshdlr(scip, "connectivity", "Segemnt connectivity constraints",
-        1000000, -2000000, -2000000, 1, -1, 1, 0,
+        1000000, -2000000, -2000000, 1, 1, 1, 0,
         FALSE, FALSE, TRUE, SCIP_PROPTIMING_BEFORELP, SCIP_PRESOLTIMING_FAST),
-    g(g_), master_nodes(master_nodes_), master_node(master_node_), superpixel_vars(superpixel_vars_)
-{}
+    g(g_), master_mask(master_mask_), master_node(master_node_), superpixel_vars(superpixel_vars_),
+    checker(g_), separator(g_), propagator(g_), trans_vars(g_.numVertices()), values(g_.numVertices()), row_vars(g_.numVertices()), row_coefs(g_.numVertices(), 1.0),
+    sepa_calls(0), sepa_time(0.0), cuts_generated(0), cuts_applied(0), pool_cuts_applied(0), flow_cuts_applied(0), prop_fixings(0), enfo_fallbacks(0),
+    pool(pool_)
+{
+    SCIP_CALL_ABORT(SCIPaddBoolParam(scip, "constraints/connectivity/maxflow",
+        "separate fractional solutions by minimum vertex separators computed with maximum flows",
+        &maxflow, FALSE, TRUE, NULL, NULL));
+}
 
 SCIP_DECL_CONSTRANS(ConnectivityCons::scip_trans)
 {
@@ -26,168 +35,322 @@ SCIP_DECL_CONSTRANS(ConnectivityCons::scip_trans)
     return SCIP_OKAY;
 }
 
-size_t ConnectivityCons::findComponents(
+SCIP_RETCODE ConnectivityCons::findComponents(
     SCIP* scip,
     SCIP_SOL* sol,
-    Graph& subgraph,
-    std::vector<int>& component
+    size_t* num_components
     )
 {
-    for (auto p = vertices(g); p.first != p.second; ++p.first)
+    size_t n = checker.size();
+    SCIP_CALL(SCIPgetSolVals(scip, sol, n, &superpixel_vars[0], &values[0]));
+    for (size_t s = 0; s < n; ++s)
     {
-        if (SCIPisEQ(scip, SCIPgetSolVal(scip, sol, superpixel_vars[*p.first]), 1.0))
-        {
-            add_vertex(*p.first, subgraph);
-        }
+        checker.select(s, SCIPisEQ(scip, values[s], 1.0));
     }
-    size_t num_components = connected_components(subgraph, &component[0]);
-    return num_components;
+    *num_components = checker.findComponents();
+    return SCIP_OKAY;
 }
 
 SCIP_RETCODE ConnectivityCons::sepaConnectivity(
     SCIP* scip,
     SCIP_CONSHDLR* conshdlr,
     SCIP_SOL* sol,
+    SCIP_Bool enforce,
     SCIP_RESULT* result
     )
 {
-    Graph& subgraph = g.create_subgraph();
-    std::vector<int> component(num_vertices(g));
-    int num_components = findComponents(scip, sol, subgraph, component);
-    if (num_components == 1)
+    size_t num_components;
+    SCIP_CALL(findComponents(scip, sol, &num_components));
+
+    // the pooled cuts also separate fractional solutions and need no search for components
+    if (pool.enabled())
     {
-        *result = SCIP_DIDNOTFIND;
+        SCIP_CALL(separatePool(scip, conshdlr, sol, enforce, result));
+        if (*result != SCIP_DIDNOTFIND)
+        {
+            return SCIP_OKAY;
+        }
     }
-    else
+
+    *result = SCIP_DIDNOTFIND;
+    size_t applied = cuts_applied;
+    for (size_t c = 0; c < num_components; ++c)
+    {
+        if (static_cast<int32_t>(c) == checker.componentOf(master_node))
+        {
+            continue;
+        }
+
+        // all superpixels surrounding the component
+        size_t boundary_size = checker.findBoundary(c);
+        const uint32_t* boundary = checker.boundaryBegin();
+        for (size_t j = 0; j < boundary_size; ++j)
+        {
+            row_vars[j] = superpixel_vars[boundary[j]];
+        }
+
+        for (const uint32_t* s = checker.componentBegin(c); s != checker.componentEnd(c); ++s)
+        {
+            SCIP_Bool infeasible;
+            SCIP_CALL(addCut(scip, conshdlr, sol, enforce, boundary_size, *s, &infeasible));
+            if (infeasible)
+            {
+                *result = SCIP_CUTOFF;
+            }
+        }
+
+        if (pool.enabled())
+        {
+            std::vector<uint32_t> component(checker.componentBegin(c), checker.componentEnd(c));
+            std::sort(component.begin(), component.end());
+            round_cuts.components.push_back(component);
+            round_cuts.boundaries.push_back(std::vector<uint32_t>(boundary, boundary + boundary_size));
+        }
+    }
+    if (*result == SCIP_CUTOFF)
+    {
+        return SCIP_OKAY;
+    }
+    if (cuts_applied > applied)
     {
         *result = SCIP_SEPARATED;
-        
-        for (int i = 0; i < num_components; i++)
+        return SCIP_OKAY;
+    }
+
+    // the boundaries of the components can have fractional values summing up to 1 or more,
+    // while other violated cuts are only found by the maximum flows
+    if (maxflow)
+    {
+        SCIP_CALL(separateFractional(scip, conshdlr, sol, enforce, result));
+    }
+    return SCIP_OKAY;
+}
+
+SCIP_RETCODE ConnectivityCons::addCut(
+    SCIP* scip,
+    SCIP_CONSHDLR* conshdlr,
+    SCIP_SOL* sol,
+    SCIP_Bool enforce,
+    size_t boundary_size,
+    uint32_t s,
+    SCIP_Bool* infeasible
+    )
+{
+    *infeasible = FALSE;
+
+    // add a constraint/row to the problem
+    SCIP_ROW* row;
+    SCIP_CALL(SCIPcreateEmptyRowCons(scip, &row, conshdlr, "sepa_con", 0.0, SCIPinfinity(scip), FALSE, FALSE, TRUE));
+    SCIP_CALL(SCIPcacheRowExtensions(scip, row));
+
+    // sum_{all superpixels s surrounding the component} x_s >= ...
+    SCIP_CALL(SCIPaddVarsToRow(scip, row, boundary_size, &row_vars[0], &row_coefs[0]));
+
+    // ... >= x_s
+    SCIP_CALL(SCIPaddVarToRow(scip, row, superpixel_vars[s], -1.0));
+
+    SCIP_CALL(SCIPflushRowExtensions(scip, row));
+    ++cuts_generated;
+    if (SCIPisCutEfficacious(scip, sol, row)
+        || (enforce && SCIPisFeasNegative(scip, SCIPgetRowSolFeasibility(scip, row, sol))))
+    {
+        SCIP_CALL(SCIPaddCut(scip, sol, row, TRUE, infeasible));
+        ++cuts_applied;
+    }
+    SCIP_CALL(SCIPreleaseRow(scip, &row));
+    return SCIP_OKAY;
+}
+
+SCIP_RETCODE ConnectivityCons::separatePool(
+    SCIP* scip,
+    SCIP_CONSHDLR* conshdlr,
+    SCIP_SOL* sol,
+    SCIP_Bool enforce,
+    SCIP_RESULT* result
+    )
+{
+    *result = SCIP_DIDNOTFIND;
+    for (size_t i = 0; i < pool.size(); ++i)
+    {
+        if (!pool.isValidFor(i, master_node))
+        {
+            continue;
+        }
+        const std::vector<uint32_t>& boundary = pool.boundary(i);
+        SCIP_Real boundary_value = 0.0;
+        for (auto s : boundary)
         {
-            if (i == component[master_node])
+            boundary_value += values[s];
+        }
+
+        bool used = false;
+        for (auto s : pool.component(i))
+        {
+            if (!SCIPisFeasGT(scip, values[s], boundary_value))
             {
                 continue;
             }
-            
-            std::vector<Graph::vertex_descriptor> superpixels; // all superpixels in the component
-            for (auto p = vertices(subgraph); p.first != p.second; ++p.first)
+            if (!used)
             {
-                if (component[*p.first] == i)
+                for (size_t j = 0; j < boundary.size(); ++j)
                 {
-                    superpixels.push_back(*p.first);
+                    row_vars[j] = superpixel_vars[boundary[j]];
                 }
+                round_cuts.used.push_back(i);
+                used = true;
             }
-
-            // fill a vector with all superpixels surrounding the component
-            std::vector<Graph::vertex_descriptor> surrounding;
-            for (auto s : superpixels)
+            SCIP_Bool infeasible;
+            size_t applied = cuts_applied;
+            SCIP_CALL(addCut(scip, conshdlr, sol, enforce, boundary.size(), s, &infeasible));
+            if (infeasible)
             {
-                for (auto q = out_edges(s, g); q.first != q.second; ++q.first)
-                {
-                    assert(boost::source(*q.first, g) == s);
-                    // if the tartget is not in the component
-                    if (std::find(
-                            superpixels.begin(),
-                            superpixels.end(),
-                            boost::target(*q.first, g)
-                        ) == superpixels.end())
-                    {
-                        surrounding.push_back(boost::target(*q.first, g));
-                    }
-                }
+                *result = SCIP_CUTOFF;
+                return SCIP_OKAY;
             }
-
-            for (auto s : superpixels)
+            if (cuts_applied > applied)
             {
-                // add a constraint/row to the problem
-                SCIP_ROW* row;
-                SCIP_CALL(SCIPcreateEmptyRowCons(scip, &row, conshdlr, "sepa_con", 0.0, SCIPinfinity(scip), FALSE, FALSE, TRUE));
-                SCIP_CALL(SCIPcacheRowExtensions(scip, row));
-                
-                // sum_{all superpixels s surrounding the component} x_s >= ...
-                for (auto s_ : surrounding)
-                {
-                    SCIP_CALL(SCIPaddVarToRow(scip, row, superpixel_vars[s_], 1.0));
-                }
-
-                // ... >= x_s
-                SCIP_CALL(SCIPaddVarToRow(scip, row, superpixel_vars[s], -1.0));
-                
-                SCIP_CALL(SCIPflushRowExtensions(scip, row));
-                if (SCIPisCutEfficacious(scip, sol, row))
-                {
-                    SCIP_Bool infeasible;
-                    SCIP_CALL(SCIPaddCut(scip, sol, row, TRUE, &infeasible));
-                    if (infeasible)
-                    {
-                        *result = SCIP_CUTOFF;
-                    }
-                }
-                SCIP_CALL(SCIPreleaseRow(scip, &row));
+                ++pool_cuts_applied;
+                *result = SCIP_SEPARATED;
             }
         }
     }
-    delete &subgraph; // delete subgraph, and thereby free memory
-    g.m_children.clear();
+    return SCIP_OKAY;
+}
+
+SCIP_RETCODE ConnectivityCons::separateFractional(
+    SCIP* scip,
+    SCIP_CONSHDLR* conshdlr,
+    SCIP_SOL* sol,
+    SCIP_Bool enforce,
+    SCIP_RESULT* result
+    )
+{
+    *result = SCIP_DIDNOTFIND;
+    size_t n = g.numVertices();
+
+    // an integral solution is connected here, because its components have already been checked
+    size_t s = 0;
+    while (s < n && SCIPisFeasIntegral(scip, values[s]))
+    {
+        ++s;
+    }
+    if (s == n)
+    {
+        return SCIP_OKAY;
+    }
+
+    for (s = 0; s < n; ++s)
+    {
+        if (s == master_node || !SCIPisFeasPositive(scip, values[s]))
+        {
+            continue;
+        }
+        // the flow stops at x_s, so it is cheap if s is well connected to the master node
+        SCIP_Real weight = separator.minimumSeparator(&values[0], master_node, s, values[s], SCIPfeastol(scip));
+        if (!SCIPisFeasLT(scip, weight, values[s]))
+        {
+            continue;
+        }
+
+        size_t separator_size = separator.findSeparator();
+        const uint32_t* superpixels = separator.separatorBegin();
+        for (size_t j = 0; j < separator_size; ++j)
+        {
+            row_vars[j] = superpixel_vars[superpixels[j]];
+        }
+        SCIP_Bool infeasible;
+        size_t applied = cuts_applied;
+        SCIP_CALL(addCut(scip, conshdlr, sol, enforce, separator_size, s, &infeasible));
+        if (infeasible)
+        {
+            *result = SCIP_CUTOFF;
+            return SCIP_OKAY;
+        }
+        if (cuts_applied > applied)
+        {
+            ++flow_cuts_applied;
+            *result = SCIP_SEPARATED;
+        }
+    }
     return SCIP_OKAY;
 }
 
 SCIP_DECL_CONSSEPALP(ConnectivityCons::scip_sepalp)
 {
-    SCIP_CALL(sepaConnectivity(scip, conshdlr, NULL, result));
+    auto start = std::chrono::steady_clock::now();
+    SCIP_CALL(sepaConnectivity(scip, conshdlr, NULL, FALSE, result));
+    sepa_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    ++sepa_calls;
     return SCIP_OKAY;
 }
 
 SCIP_DECL_CONSSEPASOL(ConnectivityCons::scip_sepasol)
 {
-    SCIP_CALL(sepaConnectivity(scip, conshdlr, sol, result));
+    auto start = std::chrono::steady_clock::now();
+    SCIP_CALL(sepaConnectivity(scip, conshdlr, sol, FALSE, result));
+    sepa_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    ++sepa_calls;
     return SCIP_OKAY;
 }
 
 SCIP_DECL_CONSENFOLP(ConnectivityCons::scip_enfolp)
 {
-    Graph& subgraph = g.create_subgraph();
-    std::vector<int> component(num_vertices(g));
-    size_t num_components = findComponents(scip, NULL, subgraph, component);
-    delete &subgraph; // delete subgraph, and thereby free memory
-    g.m_children.clear();
-    if (num_components == 1)
+    size_t num_components;
+    SCIP_CALL(findComponents(scip, NULL, &num_components));
+    if (num_components <= 1)
     {
         *result = SCIP_FEASIBLE;
+        return SCIP_OKAY;
     }
-    else
+
+    // cut off the disconnected solution instead of branching on it
+    SCIP_CALL(sepaConnectivity(scip, conshdlr, NULL, TRUE, result));
+    if (*result == SCIP_SEPARATED || *result == SCIP_CUTOFF)
     {
-        *result = SCIP_INFEASIBLE;
+        return SCIP_OKAY;
+    }
+    if (nconss > 0)
+    {
+        SCIP_CALL(propConnectivity(scip, conss[0], result));
+        if (*result == SCIP_REDUCEDDOM || *result == SCIP_CUTOFF)
+        {
+            return SCIP_OKAY;
+        }
     }
+    ++enfo_fallbacks;
+    *result = SCIP_INFEASIBLE;
     return SCIP_OKAY;
 }
 
 SCIP_DECL_CONSENFOPS(ConnectivityCons::scip_enfops)
 {
-    Graph& subgraph = g.create_subgraph();
-    std::vector<int> component(num_vertices(g));
-    size_t num_components = findComponents(scip, NULL, subgraph, component);
-    delete &subgraph; // delete subgraph, and thereby free memory
-    g.m_children.clear();
-    if (num_components == 1)
+    size_t num_components;
+    SCIP_CALL(findComponents(scip, NULL, &num_components));
+    if (num_components <= 1)
     {
         *result = SCIP_FEASIBLE;
+        return SCIP_OKAY;
     }
-    else
+
+    // pseudo solutions cannot be separated, but the domains may still be tightened
+    if (nconss > 0)
     {
-        *result = SCIP_INFEASIBLE;
+        SCIP_CALL(propConnectivity(scip, conss[0], result));
+        if (*result == SCIP_REDUCEDDOM || *result == SCIP_CUTOFF)
+        {
+            return SCIP_OKAY;
+        }
     }
+    ++enfo_fallbacks;
+    *result = SCIP_INFEASIBLE;
     return SCIP_OKAY;
 }
 
 SCIP_DECL_CONSCHECK(ConnectivityCons::scip_check)
 {
-    Graph& subgraph = g.create_subgraph();
-    std::vector<int> component(num_vertices(g));
-    size_t num_components = findComponents(scip, sol, subgraph, component);
-    delete &subgraph; // delete subgraph, and thereby free memory
-    g.m_children.clear();
-    if (num_components == 1)
+    size_t num_components;
+    SCIP_CALL(findComponents(scip, sol, &num_components));
+    if (num_components <= 1)
     {
         *result = SCIP_FEASIBLE;
     }
@@ -200,13 +363,87 @@ SCIP_DECL_CONSCHECK(ConnectivityCons::scip_check)
     
 SCIP_DECL_CONSLOCK(ConnectivityCons::scip_lock)
 {
-    for (auto p = vertices(g); p.first != p.second; ++p.first)
+    for (size_t s = 0; s < g.numVertices(); ++s)
     {
-        if (std::find(master_nodes.begin(), master_nodes.end(), *p.first) == master_nodes.end())
+        if (!master_mask[s])
         {
             // The variable x_s affects connectivity iff s is not in master_nodes,
             // since x_t=1 and x_s=0 for s in master_nodes\{t} are given
-            SCIP_CALL(SCIPaddVarLocks(scip, superpixel_vars[*p.first], nlockspos + nlocksneg, nlockspos + nlocksneg));
+            SCIP_CALL(SCIPaddVarLocks(scip, superpixel_vars[s], nlockspos + nlocksneg, nlockspos + nlocksneg));
+        }
+    }
+    return SCIP_OKAY;
+}
+
+SCIP_DECL_CONSPROP(ConnectivityCons::scip_prop)
+{
+    if (nconss == 0)
+    {
+        *result = SCIP_DIDNOTRUN;
+        return SCIP_OKAY;
+    }
+    return propConnectivity(scip, conss[0], result);
+}
+
+SCIP_RETCODE ConnectivityCons::propConnectivity(
+    SCIP* scip,
+    SCIP_CONS* cons,
+    SCIP_RESULT* result
+    )
+{
+    *result = SCIP_DIDNOTFIND;
+
+    size_t n = g.numVertices();
+    SCIP_CALL(SCIPgetTransformedVars(scip, n, &superpixel_vars[0], &trans_vars[0]));
+    for (size_t s = 0; s < n; ++s)
+    {
+        if (SCIPvarGetUbLocal(trans_vars[s]) < 0.5)
+        {
+            propagator.setState(s, ConnectivityPropagator::FIXED_ZERO);
+        }
+        else if (SCIPvarGetLbLocal(trans_vars[s]) > 0.5)
+        {
+            propagator.setState(s, ConnectivityPropagator::FIXED_ONE);
+        }
+        else
+        {
+            propagator.setState(s, ConnectivityPropagator::FREE);
+        }
+    }
+    if (!propagator.propagate(master_node))
+    {
+        *result = SCIP_CUTOFF;
+        return SCIP_OKAY;
+    }
+
+    SCIP_Bool infeasible;
+    SCIP_Bool tightened;
+    for (const uint32_t* s = propagator.unreachableBegin(); s != propagator.unreachableBegin() + propagator.numUnreachable(); ++s)
+    {
+        SCIP_CALL(SCIPinferBinvarCons(scip, trans_vars[*s], FALSE, cons, 0, &infeasible, &tightened));
+        if (infeasible)
+        {
+            *result = SCIP_CUTOFF;
+            return SCIP_OKAY;
+        }
+        if (tightened)
+        {
+            ++prop_fixings;
+            *result = SCIP_REDUCEDDOM;
+        }
+    }
+    for (const uint32_t* s = propagator.requiredBegin(); s != propagator.requiredBegin() + propagator.numRequired(); ++s)
+    {
+        SCIP_CALL(SCIPinferBinvarCons(scip, trans_vars[*s], TRUE, cons, 1, &infeasible, &tightened));
+        if (infeasible)
+        {
+            *result = SCIP_CUTOFF;
+            return SCIP_OKAY;
+        }
+        if (tightened)
+        {
+            ++prop_fixings;
+            *result = SCIP_REDUCEDDOM;
         }
     }
     return SCIP_OKAY;
@@ -1,5 +1,15 @@
+#ifndef CONNECTIVITY_CONS_H
+#define CONNECTIVITY_CONS_H
+
 #include <objscip/objscip.h>
+#include <boost/dynamic_bitset.hpp>
+#include <vector>
 #include "graph.h"
+#include "csr_graph.h"
+#include "connectivity_checker.h"
+#include "connectivity_propagator.h"
+#include "cut_pool.h"
+#include "vertex_separator.h"
 
 using namespace scip;
 
@@ -9,7 +19,22 @@ using namespace scip;
  * Whenever one of the methods `scip_enfolp`, `scip_enfops`, `scip_check` is called,
  * the connected components of the subgraph containing all superpixels \f$s\in\mathcal{S}\f$
  * for which \f$x_s = 1\f$ are calculated.
- * In `scip_enfolp`, a cutting plane is added if the current solution is infeasible.
+ * This is done by a ConnectivityChecker owned by the handler, so that no memory is allocated in these calls.
+ * In `scip_enfolp`, the violated cutting planes are added if the current solution is infeasible.
+ * Only if there are none, the enforcement tries to fix variables as in `scip_prop`,
+ * and branching is the last resort.
+ *
+ * The cutting planes only depend on the graph, not on the objective function.
+ * Before searching for new cutting planes, the separation checks the cuts in the CutPool shared by all pricing problems.
+ * The components of new cutting planes are reported to the pool at the end of each pricing round.
+ *
+ * For fractional LP solutions, the components of the superpixels with \f$x_s = 1\f$ miss most violated cuts.
+ * Therefore, if neither the pool nor the components yield a cut, a minimum weight vertex separator
+ * between the master node and each superpixel with positive value is computed by a VertexSeparator,
+ * see the parameter `constraints/connectivity/maxflow`.
+ *
+ * In `scip_prop`, superpixels that cannot be connected to the master node anymore are fixed to 0,
+ * and superpixels that every connection of a superpixel fixed to 1 has to pass are fixed to 1.
  */
 class ConnectivityCons : public ObjConshdlr 
 {
@@ -19,10 +44,11 @@ public:
      */
     ConnectivityCons(
         SCIP* scip, ///< pricer SCIP instance
-        Graph& g_, ///< the graph of superpixels
-        std::vector<Graph::vertex_descriptor>& master_nodes_, ///< master nodes of all segements 
+        const CsrGraph& g_, ///< the graph of superpixels
+        const dynamic_bitset<>& master_mask_, ///< `master_mask_[s]` is set iff \f$s\f$ is the master node of any segment
         Graph::vertex_descriptor master_node_, ///< master node of the current segement
-        std::vector<SCIP_VAR*>& superpixel_vars_ ///< vector of variables \f$x_s\f$ for each superpixel \f$s\in\mathcal{S}\f$
+        std::vector<SCIP_VAR*>& superpixel_vars_, ///< vector of variables \f$x_s\f$ for each superpixel \f$s\in\mathcal{S}\f$
+        const CutPool& pool_ ///< cuts found by the pricing problems in earlier rounds
         );
 
     /**
@@ -60,16 +86,94 @@ public:
      */ 
     virtual SCIP_DECL_CONSLOCK(scip_lock);
 
+    /**
+     * Domain propagation method of constraint handler
+     * See `propConnectivity`.
+     */
+    virtual SCIP_DECL_CONSPROP(scip_prop);
+
+    /**
+     * @return the number of calls of `sepaConnectivity` so far
+     */
+    size_t getSepaCalls() const
+    {
+        return sepa_calls;
+    }
+
+    /**
+     * @return the wall-clock time in seconds spent in `sepaConnectivity` so far
+     */
+    double getSepaTime() const
+    {
+        return sepa_time;
+    }
+
+    /**
+     * @return the pooled cuts used and the new components found since the last call of `CutPool::RoundCuts::clear`
+     */
+    CutPool::RoundCuts& getRoundCuts()
+    {
+        return round_cuts;
+    }
+
+    /**
+     * @return the number of cutting planes taken from the cut pool so far
+     */
+    size_t getPoolCutsApplied() const
+    {
+        return pool_cuts_applied;
+    }
+
+    /**
+     * @return the number of cutting planes from minimum vertex separators added to the LP so far
+     */
+    size_t getFlowCutsApplied() const
+    {
+        return flow_cuts_applied;
+    }
+
+    /**
+     * @return the number of variables fixed by `scip_prop` so far
+     */
+    size_t getPropFixings() const
+    {
+        return prop_fixings;
+    }
+
+    /**
+     * @return the number of enforcement calls that could neither add a cutting plane nor fix a variable,
+     * so that SCIP has to branch
+     */
+    size_t getEnfoFallbacks() const
+    {
+        return enfo_fallbacks;
+    }
+
+    /**
+     * @return the number of cutting planes created by `sepaConnectivity` so far
+     */
+    size_t getCutsGenerated() const
+    {
+        return cuts_generated;
+    }
+
+    /**
+     * @return the number of cutting planes that were efficacious and added to the LP so far
+     */
+    size_t getCutsApplied() const
+    {
+        return cuts_applied;
+    }
+
 private:
     /**
-     * Finds all connected components in a subgraph
-     * @return the number of connected components
+     * Finds all connected components in the subgraph induced by the superpixels \f$s\f$ for which \f$x_s = 1\f$
+     * The values of all variables are read at once, the components are stored in `checker`.
      */
-    size_t findComponents(
+    SCIP_RETCODE findComponents(
         SCIP* scip, ///< pricer SCIP instance
         SCIP_SOL* sol, ///< current primal solution or NULL
-        Graph& subgraph, ///< subgraph with all superpixels for which \f$x_s = 1\f$
-        std::vector<int>& component ///< `component[s]` will be the index of the connected component the superpixel s belongs to
+        size_t* num_components ///< pointer to store the number of connected components
     );
 
     /**
@@ -77,18 +181,94 @@ private:
      * If the current solution is infeasible, a cutting plane of the following form is added
      * for every superpixel \f$s\f$ in a component \f$C\f$ that is not connected to the master node \f$t\f$:
      * \f[\sum_{s'\in\delta(C)}x_{s'} \geq x_s\f]
+     * If none of them is efficacious and `constraints/connectivity/maxflow` is set, `separateFractional` is tried.
      */
     SCIP_RETCODE sepaConnectivity(
         SCIP* scip,
         SCIP_CONSHDLR* conshdlr,
         SCIP_SOL* sol,
+        SCIP_Bool enforce, ///< whether the solution is enforced, see `addCut`
         SCIP_RESULT* result
     );
 
-    Graph& g;
-    std::vector<Graph::vertex_descriptor>& master_nodes;
+    /**
+     * Adds the violated cuts of the cut pool that are valid for this pricing problem
+     * The values of the variables must have been read by `findComponents`.
+     */
+    SCIP_RETCODE separatePool(
+        SCIP* scip,
+        SCIP_CONSHDLR* conshdlr,
+        SCIP_SOL* sol,
+        SCIP_Bool enforce,
+        SCIP_RESULT* result
+    );
+
+    /**
+     * Adds the cutting planes \f$\sum_{s'\in S}x_{s'} \geq x_s\f$ for minimum weight vertex separators \f$S\f$
+     * Every superpixel \f$s\f$ with positive value is separated from the master node \f$t\f$ by a maximum flow,
+     * where the capacity of each superpixel is its value.
+     * The cut is violated iff the separator is lighter than \f$x_s\f$.
+     * The values of the variables must have been read by `findComponents`.
+     */
+    SCIP_RETCODE separateFractional(
+        SCIP* scip,
+        SCIP_CONSHDLR* conshdlr,
+        SCIP_SOL* sol,
+        SCIP_Bool enforce,
+        SCIP_RESULT* result
+    );
+
+    /**
+     * Fixes the variables of superpixels that cannot be connected to the master node to 0
+     * and those of superpixels that are needed to connect a superpixel fixed to 1 to 1, see ConnectivityPropagator
+     * The local bounds are read from the transformed variables.
+     */
+    SCIP_RETCODE propConnectivity(
+        SCIP* scip,
+        SCIP_CONS* cons, ///< the constraint that is the reason for the fixings
+        SCIP_RESULT* result
+    );
+
+    /**
+     * Creates the cutting plane \f$\sum_{s'\in\delta(C)}x_{s'} \geq x_s\f$ and adds it if it is efficacious
+     * During enforcement, the cutting plane is added whenever it is violated, so that the solution is cut off.
+     * The variables of \f$\delta(C)\f$ must be stored in `row_vars`.
+     */
+    SCIP_RETCODE addCut(
+        SCIP* scip,
+        SCIP_CONSHDLR* conshdlr,
+        SCIP_SOL* sol, ///< solution to separate, NULL for the current LP solution
+        SCIP_Bool enforce, ///< whether the solution is enforced
+        size_t boundary_size, ///< number of superpixels in \f$\delta(C)\f$
+        uint32_t s, ///< superpixel in \f$C\f$
+        SCIP_Bool* infeasible ///< pointer to store whether the cut renders the LP infeasible
+    );
+
+    const CsrGraph& g;
+    const dynamic_bitset<>& master_mask;
     Graph::vertex_descriptor master_node;
     std::vector<SCIP_VAR*>& superpixel_vars;
+
+    ConnectivityChecker checker;
+    VertexSeparator separator;
+    ConnectivityPropagator propagator;
+    std::vector<SCIP_VAR*> trans_vars; ///< buffer for the transformed variables \f$x_s\f$
+    std::vector<SCIP_Real> values; ///< buffer for the values of the variables \f$x_s\f$
+    std::vector<SCIP_VAR*> row_vars; ///< buffer for the variables of a cutting plane
+    std::vector<SCIP_Real> row_coefs; ///< buffer of ones for the coefficients of a cutting plane
+
+    size_t sepa_calls;
+    double sepa_time;
+    size_t cuts_generated;
+    size_t cuts_applied;
+    size_t pool_cuts_applied;
+    size_t flow_cuts_applied;
+    size_t prop_fixings;
+    size_t enfo_fallbacks;
+    SCIP_Bool maxflow; ///< whether fractional solutions are separated by `separateFractional`
+
+    const CutPool& pool;
+    CutPool::RoundCuts round_cuts;
 };
 
 /**
@@ -108,3 +288,5 @@ SCIP_RETCODE SCIPcreateConsConnectivity(
     SCIP_Bool dynamic, ///< is constraint dynamic? */
     SCIP_Bool removable ///< should the constraint be removed from the LP due to aging or cleanup? */
 );
+
+#endif
@@ -0,0 +1,92 @@
+#include <algorithm>
+#include "connectivity_propagator.h"
+
+ConnectivityPropagator::ConnectivityPropagator(const CsrGraph& g_) :
+    g(g_), num_unreachable(0), num_required(0)
+{
+    size_t n = g.numVertices();
+    state.assign(n, FREE);
+    discovered.resize(n);
+    low.resize(n);
+    subtree_fixed.resize(n);
+    is_required.resize(n);
+    next.resize(n);
+    stack.resize(n);
+    unreachable.resize(n);
+    required.resize(n);
+}
+
+bool ConnectivityPropagator::propagate(size_t t)
+{
+    size_t n = g.numVertices();
+    std::fill(discovered.begin(), discovered.end(), -1);
+    std::fill(is_required.begin(), is_required.end(), false);
+    num_required = 0;
+
+    // depth-first search over the superpixels not fixed to 0
+    int32_t time = 0;
+    size_t top = 0;
+    discovered[t] = low[t] = time++;
+    subtree_fixed[t] = state[t] == FIXED_ONE;
+    next[t] = 0;
+    stack[top++] = t;
+    while (top > 0)
+    {
+        uint32_t v = stack[top - 1];
+        if (next[v] < g.degree(v))
+        {
+            uint32_t w = g.neighboursBegin(v)[next[v]++];
+            if (state[w] == FIXED_ZERO)
+            {
+                continue;
+            }
+            if (discovered[w] < 0)
+            {
+                discovered[w] = low[w] = time++;
+                subtree_fixed[w] = state[w] == FIXED_ONE;
+                next[w] = 0;
+                stack[top++] = w;
+            }
+            else
+            {
+                low[v] = std::min(low[v], discovered[w]);
+            }
+            continue;
+        }
+
+        // v is finished, its subtree only reaches the rest of the graph through its parent iff low[v] >= discovered[parent]
+        --top;
+        if (top == 0)
+        {
+            break;
+        }
+        uint32_t parent = stack[top - 1];
+        low[parent] = std::min(low[parent], low[v]);
+        if (subtree_fixed[v] && low[v] >= discovered[parent] && parent != t
+            && state[parent] == FREE && !is_required[parent])
+        {
+            is_required[parent] = true;
+            required[num_required++] = parent;
+        }
+        subtree_fixed[parent] = subtree_fixed[parent] || subtree_fixed[v];
+    }
+
+    bool feasible = true;
+    num_unreachable = 0;
+    for (size_t s = 0; s < n; ++s)
+    {
+        if (discovered[s] >= 0 || state[s] == FIXED_ZERO)
+        {
+            continue;
+        }
+        if (state[s] == FIXED_ONE)
+        {
+            feasible = false;
+        }
+        else
+        {
+            unreachable[num_unreachable++] = s;
+        }
+    }
+    return feasible;
+}
@@ -0,0 +1,95 @@
+#ifndef CONNECTIVITY_PROPAGATOR_H
+#define CONNECTIVITY_PROPAGATOR_H
+
+#include <cstdint>
+#include <vector>
+#include "csr_graph.h"
+
+/**
+ * Derives fixings of the variables \f$x_s\f$ from the connectivity of the segment
+ * Only the superpixels that are not fixed to 0 can be part of the segment of the master node \f$t\f$. Hence
+ * - every superpixel that cannot be reached from \f$t\f$ without passing a superpixel fixed to 0 can be fixed to 0,
+ * - every articulation point of this subgraph that separates a superpixel fixed to 1 from \f$t\f$ can be fixed to 1.
+ *
+ * Both are found by a single iterative depth-first search starting at \f$t\f$ (Tarjan's algorithm),
+ * which keeps its stack in a member instead of recursing.
+ */
+class ConnectivityPropagator
+{
+public:
+    /**
+     * Domain of the variable \f$x_s\f$ of a superpixel
+     */
+    enum State : uint8_t
+    {
+        FIXED_ZERO,
+        FREE,
+        FIXED_ONE
+    };
+
+    ConnectivityPropagator(
+        const CsrGraph& g ///< the graph of superpixels
+        );
+
+    /**
+     * Sets the domain of the variable of superpixel `s`
+     */
+    void setState(size_t s, State state_)
+    {
+        state[s] = state_;
+    }
+
+    /**
+     * Finds the superpixels that have to be fixed to 0 or 1
+     * @return false if a superpixel fixed to 1 cannot be reached from `t`, i.e. the domains are infeasible
+     */
+    bool propagate(
+        size_t t ///< the master node, which must not be fixed to 0
+        );
+
+    /**
+     * @return the number of free superpixels that cannot be reached from the master node,
+     * which are stored starting at `unreachableBegin()`
+     */
+    size_t numUnreachable() const
+    {
+        return num_unreachable;
+    }
+
+    const uint32_t* unreachableBegin() const
+    {
+        return &unreachable[0];
+    }
+
+    /**
+     * @return the number of free superpixels that separate a superpixel fixed to 1 from the master node,
+     * which are stored starting at `requiredBegin()`
+     */
+    size_t numRequired() const
+    {
+        return num_required;
+    }
+
+    const uint32_t* requiredBegin() const
+    {
+        return &required[0];
+    }
+
+private:
+    const CsrGraph& g;
+
+    std::vector<State> state;
+    std::vector<int32_t> discovered; ///< DFS discovery time of each superpixel, -1 if not reached
+    std::vector<int32_t> low; ///< smallest discovery time reachable from the DFS subtree by one back edge
+    std::vector<char> subtree_fixed; ///< whether the DFS subtree of a superpixel contains a superpixel fixed to 1
+    std::vector<char> is_required;
+    std::vector<uint32_t> next; ///< index of the next neighbour to visit for each superpixel on the DFS stack
+    std::vector<uint32_t> stack;
+
+    std::vector<uint32_t> unreachable;
+    size_t num_unreachable;
+    std::vector<uint32_t> required;
+    size_t num_required;
+};
+
+#endif
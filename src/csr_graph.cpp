@@ -0,0 +1,22 @@
+#include "csr_graph.h"
+
+CsrGraph::CsrGraph(Graph& g)
+{
+    size_t n = num_vertices(g);
+    offsets.reserve(n + 1);
+    neighbours.reserve(2 * num_edges(g));
+    weights.reserve(2 * num_edges(g));
+    colors.reserve(n);
+
+    offsets.push_back(0);
+    for (auto p = vertices(g); p.first != p.second; ++p.first)
+    {
+        colors.push_back(g[*p.first].color);
+        for (auto q = out_edges(*p.first, g); q.first != q.second; ++q.first)
+        {
+            neighbours.push_back(boost::target(*q.first, g));
+            weights.push_back(boost::get(boost::edge_weight, g, *q.first));
+        }
+        offsets.push_back(neighbours.size());
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef CSR_GRAPH_H
+#define CSR_GRAPH_H
+
+#include <cstdint>
+#include <vector>
+#include "graph.h"
+
+/**
+ * Immutable superpixel graph in compressed sparse row format
+ * The graph is built once from the Boost `Graph` and stores offsets, neighbours, edge weights and colors
+ * in contiguous arrays (structure of arrays). Iterating over the neighbours of a superpixel is a linear scan,
+ * which is what the pricing heuristic, the pricing problems and the connectivity constraints need.
+ * The Boost graph is only kept where Boost algorithms are used.
+ */
+class CsrGraph
+{
+public:
+    CsrGraph(
+        Graph& g ///< the graph of superpixels
+        );
+
+    /**
+     * @return the number of superpixels
+     */
+    size_t numVertices() const
+    {
+        return colors.size();
+    }
+
+    /**
+     * @return the color \f$y_s\f$ of superpixel `s`
+     */
+    SCIP_Real color(size_t s) const
+    {
+        return colors[s];
+    }
+
+    /**
+     * @return the number of superpixels adjacent to `s`
+     */
+    size_t degree(size_t s) const
+    {
+        return offsets[s + 1] - offsets[s];
+    }
+
+    /**
+     * @return pointer to the first superpixel adjacent to `s`
+     */
+    const uint32_t* neighboursBegin(size_t s) const
+    {
+        return neighbours.data() + offsets[s];
+    }
+
+    /**
+     * @return pointer past the last superpixel adjacent to `s`
+     */
+    const uint32_t* neighboursEnd(size_t s) const
+    {
+        return neighbours.data() + offsets[s + 1];
+    }
+
+    /**
+     * @return pointer to the edge weights belonging to the superpixels in `neighboursBegin(s)`, ..., `neighboursEnd(s)`
+     */
+    const uint32_t* weightsBegin(size_t s) const
+    {
+        return weights.data() + offsets[s];
+    }
+
+private:
+    std::vector<uint32_t> offsets; ///< the neighbours of superpixel s are `neighbours[offsets[s]]`, ..., `neighbours[offsets[s+1]-1]`
+    std::vector<uint32_t> neighbours;
+    std::vector<uint32_t> weights; ///< number of neighbouring pixels, parallel to `neighbours`
+    std::vector<SCIP_Real> colors;
+};
+
+#endif
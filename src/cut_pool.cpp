@@ -0,0 +1,58 @@
+#include <algorithm>
+#include "cut_pool.h"
+
+CutPool::CutPool(size_t max_size_, size_t max_age_) :
+    max_size(max_size_), max_age(max_age_), round(0)
+{}
+
+bool CutPool::isValidFor(size_t i, uint32_t master_node) const
+{
+    const std::vector<uint32_t>& c = cuts[i].component;
+    return !std::binary_search(c.begin(), c.end(), master_node);
+}
+
+void CutPool::endRound(const std::vector<const RoundCuts*>& reports)
+{
+    ++round;
+    for (auto report : reports)
+    {
+        for (size_t i : report->used)
+        {
+            cuts[i].last_used = round;
+        }
+    }
+
+    // remove cuts that have not been used for too long, keeping the order of the remaining ones
+    size_t kept = 0;
+    for (size_t i = 0; i < cuts.size(); ++i)
+    {
+        if (round - cuts[i].last_used < max_age)
+        {
+            if (kept != i)
+            {
+                cuts[kept] = std::move(cuts[i]);
+            }
+            ++kept;
+        }
+        else
+        {
+            components.erase(cuts[i].component);
+        }
+    }
+    cuts.resize(kept);
+
+    for (auto report : reports)
+    {
+        for (size_t j = 0; j < report->components.size() && cuts.size() < max_size; ++j)
+        {
+            if (components.insert(report->components[j]).second)
+            {
+                Cut cut;
+                cut.component = report->components[j];
+                cut.boundary = report->boundaries[j];
+                cut.last_used = round;
+                cuts.push_back(std::move(cut));
+            }
+        }
+    }
+}
@@ -0,0 +1,104 @@
+#ifndef CUT_POOL_H
+#define CUT_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <vector>
+
+/**
+ * Connectivity cuts shared by the pricing problems of all master nodes
+ * A component \f$C\f$ with boundary \f$\delta(C)\f$ yields the cuts \f$\sum_{s'\in\delta(C)}x_{s'} \geq x_s\f$ for all \f$s\in C\f$.
+ * They only depend on the graph, so they are valid for the pricing problem of every master node \f$t\notin C\f$
+ * and in every pricing round.
+ *
+ * The pool is only modified between pricing rounds by `endRound`, while the pricing problems are solved it is read-only.
+ * Hence it can be read by concurrently solved pricing problems without locking, and which cuts are available
+ * does not depend on the number of threads. Cuts that were not used for a number of rounds are removed.
+ */
+class CutPool
+{
+public:
+    /**
+     * Components of the cuts found by the pricing problem of one master node in one pricing round
+     */
+    struct RoundCuts
+    {
+        std::vector<size_t> used; ///< indices of pooled cuts that were violated and added
+        std::vector<std::vector<uint32_t>> components; ///< new components, sorted
+        std::vector<std::vector<uint32_t>> boundaries; ///< boundaries of the new components, parallel to `components`
+
+        void clear()
+        {
+            used.clear();
+            components.clear();
+            boundaries.clear();
+        }
+    };
+
+    CutPool(
+        size_t max_size, ///< maximum number of components in the pool, 0 disables the pool
+        size_t max_age ///< number of rounds after which an unused component is removed
+        );
+
+    /**
+     * @return the number of components in the pool
+     */
+    size_t size() const
+    {
+        return cuts.size();
+    }
+
+    /**
+     * @return whether the pricing problems should look up and report cuts
+     */
+    bool enabled() const
+    {
+        return max_size > 0;
+    }
+
+    /**
+     * @return the sorted superpixels of component `i`
+     */
+    const std::vector<uint32_t>& component(size_t i) const
+    {
+        return cuts[i].component;
+    }
+
+    /**
+     * @return the boundary of component `i`
+     */
+    const std::vector<uint32_t>& boundary(size_t i) const
+    {
+        return cuts[i].boundary;
+    }
+
+    /**
+     * @return whether the cuts of component `i` are valid for the pricing problem of `master_node`, i.e. \f$t\notin C\f$
+     */
+    bool isValidFor(size_t i, uint32_t master_node) const;
+
+    /**
+     * Merges the cuts reported by the pricing problems in the last round into the pool and removes old cuts
+     * The reports must be given in the same order in every round, e.g. by master node, to keep the pool deterministic.
+     */
+    void endRound(
+        const std::vector<const RoundCuts*>& reports ///< the cuts used and found by each pricing problem
+        );
+
+private:
+    struct Cut
+    {
+        std::vector<uint32_t> component; ///< sorted superpixels of the component
+        std::vector<uint32_t> boundary;
+        size_t last_used; ///< last round in which the cut was found or violated
+    };
+
+    size_t max_size;
+    size_t max_age;
+    size_t round;
+    std::vector<Cut> cuts;
+    std::set<std::vector<uint32_t>> components; ///< components of all cuts in the pool, to reject duplicates
+};
+
+#endif
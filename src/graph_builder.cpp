@@ -0,0 +1,171 @@
+#include <algorithm>
+#include "graph_builder.h"
+#include "threadpool.h"
+
+namespace
+{
+    /**
+     * Counts gathered from one band of rows
+     */
+    struct Band
+    {
+        uint32_t begin; ///< first row of the band
+        uint32_t end; ///< row after the last row of the band
+        std::vector<uint32_t> numpixels; ///< number of pixels of each superpixel in the band
+        std::vector<uint64_t> edges; ///< keys of all superpixel pairs adjacent in the band, see `edgeKey`
+        std::vector<uint32_t> weights; ///< number of adjacent pixel pairs, parallel to `edges`
+    };
+
+    /**
+     * @return key identifying the undirected edge between the superpixels `a` and `b`
+     */
+    uint64_t edgeKey(uint32_t a, uint32_t b)
+    {
+        return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+    }
+
+    /**
+     * Sorts the keys in `edges` and merges equal keys by adding up their weights
+     */
+    void mergeEdges(std::vector<uint64_t>& edges, std::vector<uint32_t>& weights)
+    {
+        std::vector<size_t> permutation(edges.size());
+        for (size_t i = 0; i < permutation.size(); ++i)
+        {
+            permutation[i] = i;
+        }
+        std::sort(permutation.begin(), permutation.end(), [&edges](size_t i, size_t j) { return edges[i] < edges[j]; });
+
+        std::vector<uint64_t> merged_edges;
+        std::vector<uint32_t> merged_weights;
+        for (size_t i : permutation)
+        {
+            if (!merged_edges.empty() && merged_edges.back() == edges[i])
+            {
+                merged_weights.back() += weights[i];
+            }
+            else
+            {
+                merged_edges.push_back(edges[i]);
+                merged_weights.push_back(weights[i]);
+            }
+        }
+        edges.swap(merged_edges);
+        weights.swap(merged_weights);
+    }
+
+    /**
+     * Scans the rows of a band once and fills its tables
+     */
+    void scanBand(const uint32_t* segmentation, uint32_t width, uint32_t height, Band& band)
+    {
+        std::vector<uint64_t> pairs; // one key per adjacent pixel pair, sorted and counted afterwards
+        for (uint32_t y = band.begin; y < band.end; ++y)
+        {
+            const uint32_t* row = segmentation + size_t(y) * width;
+            const uint32_t* below = row + width;
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                ++band.numpixels[row[x]];
+                if (x + 1 < width && row[x] != row[x + 1])
+                {
+                    pairs.push_back(edgeKey(row[x], row[x + 1]));
+                }
+                // the pair with the first row of the next band also belongs to this band
+                if (y + 1 < height && row[x] != below[x])
+                {
+                    pairs.push_back(edgeKey(row[x], below[x]));
+                }
+            }
+        }
+
+        std::sort(pairs.begin(), pairs.end());
+        for (size_t i = 0; i < pairs.size(); ++i)
+        {
+            if (i > 0 && pairs[i] == pairs[i - 1])
+            {
+                ++band.weights.back();
+            }
+            else
+            {
+                band.edges.push_back(pairs[i]);
+                band.weights.push_back(1);
+            }
+        }
+    }
+}
+
+Graph buildSuperpixelGraph(
+    const uint32_t* segmentation,
+    uint32_t width,
+    uint32_t height,
+    size_t superpixelcount,
+    const std::vector<double>& colors,
+    size_t threads
+    )
+{
+    ThreadPool pool(threads);
+    // a few more bands than threads to balance the load
+    size_t num_bands = std::max<size_t>(1, std::min<size_t>(4 * pool.size(), height));
+    std::vector<Band> bands(num_bands);
+    for (size_t b = 0; b < num_bands; ++b)
+    {
+        bands[b].begin = height * b / num_bands;
+        bands[b].end = height * (b + 1) / num_bands;
+        bands[b].numpixels.assign(superpixelcount, 0);
+    }
+
+    pool.run(num_bands, [&](size_t b) {
+        scanBand(segmentation, width, height, bands[b]);
+    });
+
+    // merge the tables of all bands
+    std::vector<uint64_t> edges;
+    std::vector<uint32_t> weights;
+    for (auto& band : bands)
+    {
+        edges.insert(edges.end(), band.edges.begin(), band.edges.end());
+        weights.insert(weights.end(), band.weights.begin(), band.weights.end());
+    }
+    mergeEdges(edges, weights);
+
+    // band b stores the pixels of superpixel s starting at `offsets[b * superpixelcount + s]`
+    std::vector<size_t> offsets(num_bands * superpixelcount);
+    std::vector<size_t> numpixels(superpixelcount, 0);
+    for (size_t b = 0; b < num_bands; ++b)
+    {
+        for (size_t s = 0; s < superpixelcount; ++s)
+        {
+            offsets[b * superpixelcount + s] = numpixels[s];
+            numpixels[s] += bands[b].numpixels[s];
+        }
+    }
+
+    // materialize the graph
+    Graph g(superpixelcount);
+    for (size_t s = 0; s < superpixelcount; ++s)
+    {
+        g[s].color = colors[s];
+        g[s].pixels.resize(numpixels[s], Pixel(0, 0));
+    }
+    for (size_t i = 0; i < edges.size(); ++i)
+    {
+        Graph::edge_property_type properties(0, weights[i]);
+        add_edge(edges[i] >> 32, edges[i] & 0xffffffff, properties, g);
+    }
+
+    // store the corresponding pixels for each superpixel
+    pool.run(num_bands, [&](size_t b) {
+        size_t* next = &offsets[b * superpixelcount];
+        for (uint32_t y = bands[b].begin; y < bands[b].end; ++y)
+        {
+            const uint32_t* row = segmentation + size_t(y) * width;
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                Graph::vertex_descriptor superpixel = row[x];
+                g[superpixel].pixels[next[superpixel]++] = Pixel(x, y);
+            }
+        }
+    });
+    return g;
+}
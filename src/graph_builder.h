@@ -0,0 +1,25 @@
+#ifndef GRAPH_BUILDER_H
+#define GRAPH_BUILDER_H
+
+#include <cstdint>
+#include <vector>
+#include "graph.h"
+
+/**
+ * Builds the graph of superpixels from a label image
+ * The image is split into bands of rows, which are scanned row by row in parallel.
+ * Each band counts the pixels of every superpixel and the boundary pixel pairs between superpixels
+ * into its own flat tables. The tables are merged afterwards and the graph is created in one step,
+ * followed by a second parallel pass that stores the pixels of each superpixel.
+ * @return graph with one vertex per superpixel, where the edge weights are the numbers of adjacent pixel pairs
+ */
+Graph buildSuperpixelGraph(
+    const uint32_t* segmentation, ///< superpixel label of each pixel, stored row by row
+    uint32_t width, ///< width of the image
+    uint32_t height, ///< height of the image
+    size_t superpixelcount, ///< number of superpixels, all labels must be smaller
+    const std::vector<double>& colors, ///< color of each superpixel
+    size_t threads ///< number of threads, 0 for one per hardware thread
+    );
+
+#endif
@@ -1,196 +1,173 @@
 #include <vl/slic.h>
 #include <png++/png.hpp>
-#include <iostream>
+#include <algorithm>
+#include <chrono>
 #include <cmath>
 #include "graph.h"
+#include "graph_builder.h"
 #include "image.h"
+#include "threadpool.h"
 
 
-Image::Image(std::string filename_, int n) : filename(filename_)
+Image::Image(std::string filename_, int n, std::string output_prefix_) :
+    filename(filename_),
+    output_prefix(output_prefix_)
+{
+    typedef std::chrono::steady_clock Clock;
+    auto start = Clock::now();
+    std::vector<uint8_t> gray;
+    std::vector<float> normalized;
+    load(filename, width, height, gray, normalized);
+    auto loaded = Clock::now();
+    load_time = std::chrono::duration<double>(loaded - start).count();
+
+    superpixelcount = slic(normalized, width, height, n, segmentation);
+    computeColors(gray);
+    writeSuperpixels(gray);
+    slic_time = std::chrono::duration<double>(Clock::now() - loaded).count();
+}
+
+void Image::load(const std::string& filename, unsigned int& width, unsigned int& height, std::vector<uint8_t>& gray, std::vector<float>& normalized)
 {
     png::image<png::gray_pixel> pngimage(filename);
     width = pngimage.get_width();
     height = pngimage.get_height();
-    unsigned int imagesize = pngimage.get_width() * pngimage.get_height();
-    
-    float* image = new float[imagesize];
-    for (png::uint_32 x = 0; x < pngimage.get_width(); ++x)
+    gray.resize(size_t(width) * height);
+    normalized.resize(size_t(width) * height);
+    for (png::uint_32 y = 0; y < height; ++y)
     {
-        for (png::uint_32 y = 0; y < pngimage.get_height(); ++y)
+        for (png::uint_32 x = 0; x < width; ++x)
         {
-            image[x + y * pngimage.get_width()] = pngimage[y][x] / 255.0;
+            gray[x + y * width] = pngimage[y][x];
+            normalized[x + y * width] = pngimage[y][x] / 255.0;
         }
     }
-    
-    segmentation = new vl_uint32[imagesize];
+}
+
+unsigned int Image::slic(const std::vector<float>& normalized, unsigned int width, unsigned int height, int n, std::vector<uint32_t>& segmentation)
+{
+    unsigned int imagesize = width * height;
+    segmentation.resize(imagesize);
     vl_slic_segment(
-        segmentation,
-        image,
-        pngimage.get_width(),
-        pngimage.get_height(),
+        segmentation.data(),
+        normalized.data(),
+        width,
+        height,
         1, // numChannels
         sqrt(imagesize / n), // regionSize
         10.0, // regularization
         0 // minRegionSize
     );
-    
-    superpixelcount = 0;
-    for (size_t i = 0; i < imagesize; ++i)
-    {
-        if (superpixelcount < segmentation[i])
-        {
-            superpixelcount = segmentation[i];
-        }
-    }
-    superpixelcount++;
-    std::cout << "Generated " << superpixelcount << " superpixels." << std::endl;
-    
-    avgcolor.resize(superpixelcount, 0.0);
+    return *std::max_element(segmentation.begin(), segmentation.end()) + 1;
+}
+
+void Image::computeColors(const std::vector<uint8_t>& gray)
+{
+    avgcolor.assign(superpixelcount, 0.0);
     std::vector<unsigned int> numpixels(superpixelcount, 0);
-    for (png::uint_32 x = 0; x < pngimage.get_width(); ++x)
+    for (size_t i = 0; i < gray.size(); ++i)
     {
-        for (png::uint_32 y = 0; y < pngimage.get_height(); ++y)
-        {
-            avgcolor[segmentation[x + y * pngimage.get_width()]] += pngimage[y][x];
-            numpixels[segmentation[x + y * pngimage.get_width()]] += 1;
-        }
+        avgcolor[segmentation[i]] += gray[i];
+        numpixels[segmentation[i]] += 1;
     }
     for (size_t i = 0; i < superpixelcount; ++i)
     {
         avgcolor[i] /= numpixels[i];
     }
-    
-    png::image<png::gray_pixel> pngimage2(pngimage);
-    for (png::uint_32 x = 0; x < pngimage.get_width(); ++x)
+}
+
+void Image::writeSuperpixels(const std::vector<uint8_t>& gray)
+{
+    png::image<png::gray_pixel> pngimage(width, height);
+    png::image<png::gray_pixel> pngimage2(width, height);
+    bordered.resize(gray.size());
+    for (png::uint_32 y = 0; y < height; ++y)
     {
-        for (png::uint_32 y = 0; y < pngimage.get_height(); ++y)
+        for (png::uint_32 x = 0; x < width; ++x)
         {
-            auto current = x + y * width;
-            auto right = x + 1 + y * width;
-            auto left = x - 1 + y * width;
-            auto below = x + (y + 1) * width;
-            auto above = x + (y - 1) * width;
-            if (x + 1 < width && segmentation[current] != segmentation[right])
-            {
-                pngimage[y][x] = 0; // set pixel at the border to black
-                pngimage2[y][x] = 0; // set pixel at the border to black
-            }
-            else if (x >= 1 && segmentation[current] != segmentation[left])
-            {
-                pngimage[y][x] = 0; // set pixel at the border to black
-                pngimage2[y][x] = 0; // set pixel at the border to black
-            }
-            else if (y + 1 < height && segmentation[current] != segmentation[below])
-            {
-                pngimage[y][x] = 0; // set pixel at the border to black
-                pngimage2[y][x] = 0; // set pixel at the border to black
-            }
-            else if (y  >= 1 && segmentation[current] != segmentation[above])
+            size_t current = x + y * width;
+            uint32_t superpixel = segmentation[current];
+            if ((x + 1 < width && superpixel != segmentation[current + 1])
+                || (x >= 1 && superpixel != segmentation[current - 1])
+                || (y + 1 < height && superpixel != segmentation[current + width])
+                || (y >= 1 && superpixel != segmentation[current - width]))
             {
-                pngimage[y][x] = 0; // set pixel at the border to black
+                bordered[current] = 0; // set pixel at the border to black
                 pngimage2[y][x] = 0; // set pixel at the border to black
             }
             else
             {
-                pngimage2[y][x] = avgcolor[segmentation[x + y * pngimage.get_width()]];
+                bordered[current] = gray[current];
+                pngimage2[y][x] = avgcolor[superpixel];
             }
+            pngimage[y][x] = bordered[current];
         }
     }
-    pngimage.write("superpixels.png");
-    pngimage2.write("superpixels_avgcolor.png");
+    pngimage.write(outputPath("superpixels.png"));
+    pngimage2.write(outputPath("superpixels_avgcolor.png"));
 }
 
-Graph Image::graph()
+Graph Image::graph(size_t threads)
 {
-    Graph g(superpixelcount);
-    for (auto p = vertices(g); p.first != p.second; ++p.first)
-    {
-        g[*p.first].color = avgcolor[*p.first];
-    }
-
-    // store the corresponding pixels for each superpixel
-    for (png::uint_32 x = 0; x < width; ++x)
-    {
-        for (png::uint_32 y = 0; y < height; ++y)
-        {
-            Graph::vertex_descriptor superpixel = segmentation[x + y * width];
-            g[superpixel].pixels.push_back(Pixel{x, y});
-        }
-    }
-
-    // add edges
-    for (png::uint_32 x = 0; x < width; ++x)
-    {
-        for (png::uint_32 y = 0; y < height; ++y)
-        {
-            auto current = x + y * width;
-            auto right = x + 1 + y * width;
-            auto below = x + (y + 1) * width;
-            if (x + 1 < width
-                && segmentation[current] != segmentation[right])
-            {
-                // add edge to the superpixel on the right
-                auto edge = add_edge(segmentation[current], segmentation[right], g); // returns a pair<edge_descriptor, bool>
-                auto weight = boost::get(boost::edge_weight, g, edge.first);
-                boost::put(boost::edge_weight, g, edge.first, weight + 1);
-            }
-            if (y + 1 < height
-                && segmentation[current] != segmentation[below])
-            {
-                // add edge to the superpixel below
-                auto edge = add_edge(segmentation[current], segmentation[below], g);
-                auto weight = boost::get(boost::edge_weight, g, edge.first);
-                boost::put(boost::edge_weight, g, edge.first, weight + 1);
-            }
-        }
-    }
-    return g;
+    return buildSuperpixelGraph(segmentation.data(), width, height, superpixelcount, avgcolor, threads);
 }
 
-void Image::writeSegments(std::vector<Graph::vertex_descriptor> master_nodes, std::vector<std::vector<Graph::vertex_descriptor>> segments, Graph& g)
+void Image::writeSegments(std::vector<Graph::vertex_descriptor> master_nodes, std::vector<std::vector<Graph::vertex_descriptor>> segments, Graph& g, size_t threads)
 {
-    std::vector<std::vector<size_t>> pixeltosegment(height);
-    for (size_t i = 0; i < pixeltosegment.size(); ++i)
-        pixeltosegment[i].resize(width);
-    for (png::uint_32 x = 0; x < width; ++x)
+    // segment of each superpixel and whether it is a master node, so that each pixel needs only table lookups
+    std::vector<uint32_t> superpixeltosegment(superpixelcount, 0);
+    for (size_t i = 0; i < segments.size(); ++i)
     {
-        for (png::uint_32 y = 0; y < height; ++y)
+        for (auto superpixel : segments[i])
         {
-            Graph::vertex_descriptor superpixel = segmentation[x + y*width];
-            size_t segment = 0;
-            while (std::find(segments[segment].begin(), segments[segment].end(), superpixel) == segments[segment].end())
-                ++segment;
-            pixeltosegment[y][x] = segment;
+            superpixeltosegment[superpixel] = i;
         }
     }
-    
-    png::image<png::rgb_pixel> pngimage("superpixels.png");
-    for (png::uint_32 x = 0; x < width; ++x)
+    std::vector<char> is_master(superpixelcount, false);
+    for (auto t : master_nodes)
     {
-        for (png::uint_32 y = 0; y < height; ++y)
+        is_master[t] = true;
+    }
+
+    // render the image row by row into a flat buffer
+    std::vector<png::rgb_pixel> buffer(size_t(width) * height);
+    ThreadPool pool(threads);
+    pool.run(height, [&](size_t y) {
+        const uint32_t* row = segmentation.data() + y * width;
+        for (png::uint_32 x = 0; x < width; ++x)
         {
+            uint32_t segment = superpixeltosegment[row[x]];
             // if the pixel is at a boundary between segments
-            if ((x > 0 && pixeltosegment[y][x] != pixeltosegment[y][x-1])
-                || (x+1 < width && pixeltosegment[y][x] != pixeltosegment[y][x+1])
-                || (y > 0 && pixeltosegment[y][x] != pixeltosegment[y-1][x])
-                || (y+1 < height && pixeltosegment[y][x] != pixeltosegment[y+1][x]))
+            if ((x > 0 && segment != superpixeltosegment[row[x - 1]])
+                || (x + 1 < width && segment != superpixeltosegment[row[x + 1]])
+                || (y > 0 && segment != superpixeltosegment[row[x - width]])
+                || (y + 1 < height && segment != superpixeltosegment[row[x + width]]))
             {
-                pngimage[y][x] = png::rgb_pixel(255, 0, 0); // colour pixel at segment boundary red
+                buffer[x + y * width] = png::rgb_pixel(255, 0, 0); // colour pixel at segment boundary red
             }
             // if the pixel is at the boundary of a master node
-            else if (std::find(master_nodes.begin(), master_nodes.end(), segmentation[x + y*width]) != master_nodes.end()
-                && ((x+1 < width && segmentation[x + y*width] != segmentation[x+1 + y*width])
-                || (y+1 < height && segmentation[x + y*width] != segmentation[x + (y+1)*width])
-                || (x > 0 && segmentation[x + y*width] != segmentation[x-1 + y*width])
-                || (y > 0 && segmentation[x + y*width] != segmentation[x + (y-1)*width])))
+            else if (is_master[row[x]]
+                && ((x + 1 < width && row[x] != row[x + 1])
+                || (y + 1 < height && row[x] != row[x + width])
+                || (x > 0 && row[x] != row[x - 1])
+                || (y > 0 && row[x] != row[x - width])))
             {
-                pngimage[y][x] = png::rgb_pixel(0, 0, 255); // colour pixel blue
+                buffer[x + y * width] = png::rgb_pixel(0, 0, 255); // colour pixel blue
+            }
+            else
+            {
+                png::gray_pixel gray = bordered[x + y * width];
+                buffer[x + y * width] = png::rgb_pixel(gray, gray, gray);
             }
         }
-    }
-    
-    std::cout << "write segments.png" << std::endl;
-    pngimage.write("segments.png");
+    });
+
+    png::image<png::rgb_pixel> pngimage(width, height);
+    pool.run(height, [&](size_t y) {
+        std::copy(&buffer[y * width], &buffer[y * width] + width, pngimage[y].begin());
+    });
+
+    pngimage.write(outputPath("segments.png"));
 }
 
 uint32_t Image::pixelToSuperpixel(uint32_t x, uint32_t y)
@@ -6,35 +6,128 @@
  */
 class Image {
 public:
+    /**
+     * Reads the image, computes the superpixels and writes `superpixels.png` and `superpixels_avgcolor.png`
+     */
     Image(
         std::string filename, ///< PNG image to read
-        int n ///< desired number of superpixels
+        int n, ///< desired number of superpixels
+        std::string output_prefix = "" ///< prepended to the names of all files written for this image
+        );
+
+    /**
+     * Reads a grayscale PNG image
+     * This is the first step of the constructor.
+     */
+    static void load(
+        const std::string& filename, ///< PNG image to read
+        unsigned int& width, ///< the width of the image is stored in here
+        unsigned int& height, ///< the height of the image is stored in here
+        std::vector<uint8_t>& gray, ///< the intensities are stored in here in row-major order
+        std::vector<float>& normalized ///< the intensities scaled to \f$[0,1]\f$ are stored in here in row-major order
+        );
+
+    /**
+     * Computes SLIC superpixels using VLFeat
+     * This is the second step of the constructor.
+     * @return the number of superpixels
+     */
+    static unsigned int slic(
+        const std::vector<float>& normalized, ///< intensities scaled to \f$[0,1]\f$
+        unsigned int width,
+        unsigned int height,
+        int n, ///< desired number of superpixels
+        std::vector<uint32_t>& segmentation ///< the superpixel of each pixel is stored in here in row-major order
         );
     
     /**
      * Creates a Boost graph consisting of the generated superpixels
      * The number of adjacent pixels between superpixels is stored as edge weight.
+     * The label image is scanned in parallel, see `buildSuperpixelGraph`.
      */
-    Graph graph(); 
+    Graph graph(
+        size_t threads = 0 ///< number of threads, 0 for one per hardware thread
+        );
 
     /*
-     * Writes segements into segments.png
+     * Writes segements into segments.png, prefixed by the output prefix
+     * The segment of each pixel is looked up in a table indexed by superpixel,
+     * and the rows of the image are rendered in parallel.
      */
     void writeSegments(
         std::vector<Graph::vertex_descriptor> master_nodes,  ///< master nodes of all segments 
         std::vector<std::vector<Graph::vertex_descriptor>> segments, ///< optimal segmentation, where each segment is a vector consisting of the superpixels contained in it
-        Graph& g ///< the graph of superpixels 
+        Graph& g, ///< the graph of superpixels 
+        size_t threads = 0 ///< number of threads, 0 for one per hardware thread
         );
 
     uint32_t pixelToSuperpixel(uint32_t x, uint32_t y);
+
+    /**
+     * @return the path of the output file `name` of this image
+     */
+    std::string outputPath(const std::string& name) const
+    {
+        return output_prefix + name;
+    }
+
+    const std::string& getFilename() const
+    {
+        return filename;
+    }
+
+    unsigned int getWidth() const
+    {
+        return width;
+    }
+
+    unsigned int getHeight() const
+    {
+        return height;
+    }
+
+    unsigned int getSuperpixelCount() const
+    {
+        return superpixelcount;
+    }
+
+    /**
+     * @return the wall-clock time in seconds the constructor spent reading the image
+     */
+    double getLoadTime() const
+    {
+        return load_time;
+    }
+
+    /**
+     * @return the wall-clock time in seconds the constructor spent computing the superpixels and writing the superpixel images
+     */
+    double getSlicTime() const
+    {
+        return slic_time;
+    }
     
 private:
+    /**
+     * Computes the average color of each superpixel
+     */
+    void computeColors(const std::vector<uint8_t>& gray);
+
+    /**
+     * Draws the superpixel boundaries and writes `superpixels.png` and `superpixels_avgcolor.png`
+     */
+    void writeSuperpixels(const std::vector<uint8_t>& gray);
+
     unsigned int width;
     unsigned int height;
     unsigned int superpixelcount;
-    uint32_t* segmentation;
+    std::vector<uint32_t> segmentation; ///< superpixel of each pixel in row-major order
     std::vector<double> avgcolor;
+    std::vector<uint8_t> bordered; ///< the input image with black superpixel boundaries, as written to superpixels.png
     std::string filename;
+    std::string output_prefix;
+    double load_time;
+    double slic_time;
 };
 
 #endif
@@ -1,214 +1,265 @@
 /** @file */ 
 
 #include "graph.h"
-#include <boost/graph/adjacency_list.hpp>
-#include <boost/random/linear_congruential.hpp>
-#include <boost/graph/random.hpp>
-#include <boost/graph/connected_components.hpp>
-#include "pricer.h"
-
-#include <scip/scipdefplugins.h>
 
+#include <climits>
+#include <cstdlib>
 #include <iostream>
-#include <math.h>
+#include <memory>
 #include <string>
 
-#include "vardata.h"
 #include "image.h"
+#include "seeds.h"
+#include "master.h"
+#include "batch.h"
+#include "stats.h"
 
 #include <opencv2/imgproc/imgproc.hpp>
 #include <opencv2/highgui/highgui.hpp>
 
 using namespace cv;
 
+std::vector<std::pair<uint32_t, uint32_t>> master_pixels;
+
+static void onMouse(int event, int x, int y, int f, void*)
+{
+    if (event == CV_EVENT_LBUTTONDOWN)
+    {
+        std::cout << x << " " << y << std::endl;
+        master_pixels.push_back(std::pair<uint32_t, uint32_t>(x, y));
+    }
+}
+
+static void printUsage()
+{
+    std::cout << "Usage: bin/fopra input.png num_superpixels [options]" << std::endl
+        << "       bin/fopra --manifest FILE [--jobs N] [--threads N] [--smoothing ALPHA] [--gaptol GAP] [--pricing ENGINE]" << std::endl
+        << "                          [--initial SEGMENTS]" << std::endl
+        << "Options:" << std::endl
+        << "  --threads N             number of threads building the graph, solving the pricing problems" << std::endl
+        << "                          and rendering the result (default 1)" << std::endl
+        << "  --smoothing ALPHA       stabilize the duals by Wentges smoothing with factor ALPHA in [0, 0.99]," << std::endl
+        << "                          0 prices at the duals of the master LP (default 0)" << std::endl
+        << "  --gaptol GAP            stop pricing once the relative gap between the master LP and the Lagrangian bound" << std::endl
+        << "                          is at most GAP in [0, 1], 0 solves the master LP to optimality (default 0)" << std::endl
+        << "  --pricing ENGINE        solve the pricing problems exactly by \"bb\" (combinatorial branch-and-bound, falling back" << std::endl
+        << "                          to SCIP on hard instances), \"mip\" (SCIP) or \"validate\" (both, reporting different" << std::endl
+        << "                          optimal values) (default mip)" << std::endl
+        << "  --initial SEGMENTS      start the column generation with \"grown\" segments, grown from all master nodes at once" << std::endl
+        << "                          by color distance, or only with \"artificial\" segments of prohibitive costs (default grown)" << std::endl
+        << "  --seeds FILE            read master nodes from FILE, one \"x y\" (pixel) or \"s id\" (superpixel) per line" << std::endl
+        << "  --pixels x,y;x,y;...    master nodes given by pixel coordinates" << std::endl
+        << "  --superpixels id,id,... master nodes given by superpixel ids" << std::endl
+        << "  --manifest FILE         segment every image listed in FILE, one \"image num_superpixels seeds_file [output_prefix]\" per line" << std::endl
+        << "  --report FILE           write timings and solver statistics as JSON to FILE, an array of one object per image with --manifest" << std::endl
+        << "  --jobs N                number of images segmented concurrently with --manifest, 0 for one per hardware thread (default 1)" << std::endl
+        << "If master nodes are given by --seeds, --pixels or --superpixels, the program runs without opening any window." << std::endl;
+}
+
 /**
- * Setup and solve the master problem
+ * The main function reads the image, retrieves the graph of superpixels, solves the master problem and outputs the solution.
+ * The master nodes are either selected by clicking into a window, or given on the command line for unattended runs.
+ * With `--manifest`, a whole batch of images is segmented without interaction, see `runBatch`.
  */
-SCIP_RETCODE master_problem(
-    Graph& g, ///< the graph of superpixels
-    std::vector<Graph::vertex_descriptor> master_nodes, ///< master nodes of all segments 
-    std::vector<std::set<Graph::vertex_descriptor>> initial_segments, ///< an initial set of segments that will be added as variables
-                                                                      ///< These should form a feasible solution, but do not need to be connected.
-    std::vector<std::vector<Graph::vertex_descriptor>>& segments ///< the selected segments will be stored in here
-)
+int main(int argc, char** argv)
 {
-    SCIP* scip;
-    SCIP_CALL(SCIPcreate(& scip));
-    SCIP_CALL(SCIPincludeDefaultPlugins(scip));
-    SCIP_CALL(SCIPsetIntParam(scip, "display/verblevel", 5));
-    SCIP_CALL(SCIPsetIntParam(scip, "presolving/maxrestarts", 0)); // see Known Bugs at http://scip.zib.de/#contact
-    
-    //create master problem
-    SCIP_CALL(SCIPcreateProb(scip, "master_problem", NULL, NULL, NULL, NULL, NULL, NULL, NULL));
-    SCIP_CALL(SCIPsetObjsense(scip, SCIP_OBJSENSE_MINIMIZE));
-    
-    std::vector<SCIP_VAR*> vars;
-    // vars[i] belongs to segment initial_segments[i]
-    for (auto segment : initial_segments)
+    bool batch = argc >= 2 && std::string(argv[1]) == "--manifest";
+    if (argc < 3)
     {
-        SCIP_VAR* var;
-        // Set a very high objective value for the initial segments so that they aren't selected in the final solution
-        SCIP_CALL(SCIPcreateVar(scip, &var, "x_P", 0.0, 1.0, 10000, SCIP_VARTYPE_BINARY, TRUE, FALSE, NULL, NULL, NULL, NULL, NULL));
-        SCIP_CALL(SCIPaddVar(scip, var));
-        vars.push_back(var);
+        printUsage();
+        return STATUS_USAGE;
     }
-    
-    std::vector<SCIP_CONS*> partitioning_cons;
-    for (auto p = vertices(g); p.first != p.second; ++p.first)
+    SolverOptions options;
+    int parallel_jobs = 1;
+    std::string report;
+    Seeds seeds;
+    std::vector<BatchJob> jobs;
+    for (int i = batch ? 1 : 3; i < argc; ++i)
     {
-        SCIP_CONS* cons1;
-        SCIP_CALL(SCIPcreateConsLinear(scip, & cons1, "first", 0, NULL, NULL, 1.0, 1.0,
-                     true,                   /* initial */
-                     false,                  /* separate */
-                     true,                   /* enforce */
-                     true,                   /* check */
-                     true,                   /* propagate */
-                     false,                  /* local */
-                     true,                   /* modifiable */
-                     false,                  /* dynamic */
-                     false,                  /* removable */
-                     false) );               /* stickingatnode */
-        for (size_t i = 0; i != initial_segments.size(); ++i)
+        std::string option = argv[i];
+        if (i + 1 == argc)
+        {
+            std::cerr << "Missing value for option " << option << std::endl;
+            printUsage();
+            return STATUS_USAGE;
+        }
+        std::string value = argv[++i];
+        if (option == "--threads")
         {
-            if (initial_segments[i].find(*p.first) != initial_segments[i].end())
+            char* end;
+            long threads = std::strtol(value.c_str(), &end, 10);
+            if (*end != '\0' || value.empty() || threads < 1 || threads > 256)
             {
-                SCIP_CALL(SCIPaddCoefLinear(scip, cons1, vars[i], 1.0));
+                std::cerr << "Invalid number of threads " << value << ", expected a number in [1, 256]" << std::endl;
+                return STATUS_USAGE;
             }
+            options.threads = threads;
         }
-        SCIP_CALL(SCIPaddCons(scip, cons1));
-        partitioning_cons.push_back(cons1);
-    }
-    
-    SCIP_CONS* num_segments_cons;
-    size_t k = initial_segments.size();
-    SCIP_CALL(SCIPcreateConsLinear(scip, &num_segments_cons, "second", 0, NULL, NULL, k, k,
-                     true,                   /* initial */
-                     false,                  /* separate */
-                     true,                   /* enforce */
-                     true,                   /* check */
-                     true,                   /* propagate */
-                     false,                  /* local */
-                     true,                   /* modifiable */
-                     false,                  /* dynamic */
-                     false,                  /* removable */
-                     false) );               /* stickingatnode */
-    for (size_t i = 0; i != initial_segments.size(); ++i)
-    {
-        SCIP_CALL(SCIPaddCoefLinear(scip, num_segments_cons, vars[i], 1.0));
-    }
-    SCIP_CALL(SCIPaddCons(scip, num_segments_cons));
-    
-    // include pricer 
-    SegmentPricer* pricer_ptr = new SegmentPricer(scip, g, master_nodes, partitioning_cons, num_segments_cons);
-    SCIP_CALL(SCIPincludeObjPricer(scip, pricer_ptr, true));
-    
-    // activate pricer 
-    SCIP_CALL(SCIPactivatePricer(scip, SCIPfindPricer(scip, "fitting_pricer")));
-    
-    // solve
-    SCIP_CALL(SCIPsolve(scip));
-    SCIP_SOL* sol = SCIPgetBestSol(scip);
-
-    // return selected segments
-    SCIP_VAR** variables = SCIPgetVars(scip);
-    for (int i = 0; i < SCIPgetNVars(scip); ++i)
-    {
-        if (SCIPisEQ(scip, SCIPgetSolVal(scip, sol, variables[i]), 1.0))
+        else if (option == "--smoothing")
+        {
+            char* end;
+            options.smoothing = std::strtod(value.c_str(), &end);
+            if (*end != '\0' || value.empty() || !(options.smoothing >= 0.0 && options.smoothing <= 0.99))
+            {
+                std::cerr << "Invalid smoothing factor " << value << ", expected a number in [0, 0.99]" << std::endl;
+                return STATUS_USAGE;
+            }
+        }
+        else if (option == "--gaptol")
         {
-            auto vardata = (ObjVardataSegment*) SCIPgetObjVardata(scip, variables[i]);
-            segments.push_back(vardata->getSuperpixels());
+            char* end;
+            options.gap_tolerance = std::strtod(value.c_str(), &end);
+            if (*end != '\0' || value.empty() || !(options.gap_tolerance >= 0.0 && options.gap_tolerance <= 1.0))
+            {
+                std::cerr << "Invalid gap tolerance " << value << ", expected a number in [0, 1]" << std::endl;
+                return STATUS_USAGE;
+            }
         }
-    }
-
-    // check if the selected segments are connected
-    for (auto segment : segments)
-    {
-        Graph& subgraph = g.create_subgraph();
-        std::vector<int> component(num_vertices(g));
-        for (auto superpixel : segment)
+        else if (option == "--pricing")
         {
-            add_vertex(superpixel, subgraph);
+            if (value == "bb" || value == "validate")
+            {
+                options.pricing_engine = 1;
+                options.validate_pricing = value == "validate";
+            }
+            else if (value == "mip")
+            {
+                options.pricing_engine = 0;
+            }
+            else
+            {
+                std::cerr << "Invalid pricing engine " << value << ", expected bb, mip or validate" << std::endl;
+                return STATUS_USAGE;
+            }
+        }
+        else if (option == "--initial")
+        {
+            if (value != "grown" && value != "artificial")
+            {
+                std::cerr << "Invalid initial segments " << value << ", expected grown or artificial" << std::endl;
+                return STATUS_USAGE;
+            }
+            options.grow_segments = value == "grown";
+        }
+        else if (option == "--report")
+        {
+            report = value;
+        }
+        else if (option == "--jobs" && batch)
+        {
+            char* end;
+            long jobs = std::strtol(value.c_str(), &end, 10);
+            if (*end != '\0' || value.empty() || jobs < 0 || jobs > INT_MAX)
+            {
+                std::cerr << "Invalid number of jobs " << value << std::endl;
+                return STATUS_USAGE;
+            }
+            parallel_jobs = jobs;
+        }
+        else if (option == "--manifest" && batch && jobs.empty())
+        {
+            if (!readManifest(value, jobs))
+            {
+                return STATUS_INPUT;
+            }
+        }
+        else if (option == "--seeds" && !batch)
+        {
+            if (!readSeedsFile(value, seeds))
+            {
+                return STATUS_INPUT;
+            }
+        }
+        else if (option == "--pixels" && !batch)
+        {
+            if (!parsePixelList(value, seeds))
+            {
+                return STATUS_USAGE;
+            }
+        }
+        else if (option == "--superpixels" && !batch)
+        {
+            if (!parseSuperpixelList(value, seeds))
+            {
+                return STATUS_USAGE;
+            }
+        }
+        else
+        {
+            std::cerr << "Unknown option " << option << std::endl;
+            printUsage();
+            return STATUS_USAGE;
         }
-        assert(connected_components(subgraph, &component[0]) == 1);
     }
-    
-    return SCIP_OKAY;
-}
-
-std::vector<std::pair<uint32_t, uint32_t>> master_pixels;
-
-static void onMouse(int event, int x, int y, int f, void*)
-{
-    if (event == CV_EVENT_LBUTTONDOWN)
+    if (batch)
     {
-        std::cout << x << " " << y << std::endl;
-        master_pixels.push_back(std::pair<uint32_t, uint32_t>(x, y));
+        return runBatch(jobs, parallel_jobs, options, report);
     }
-}
+    bool interactive = seeds.empty();
 
-/**
- * The main function reads the image, retrieves the graph of superpixels, solves the master problem and outputs the solution.
- */
-int main(int argc, char** argv)
-{
-    if (argc != 3)
+    char* end;
+    long superpixels = std::strtol(argv[2], &end, 10);
+    if (*end != '\0' || *argv[2] == '\0' || superpixels < 1 || superpixels > INT_MAX)
+    {
+        std::cerr << "Invalid number of superpixels " << argv[2] << std::endl;
+        return STATUS_USAGE;
+    }
+    std::unique_ptr<Image> image;
+    try
     {
-        std::cout << "Usage: bin/fopra input.png num_superpixels" << std::endl;
-        return 1;
+        image.reset(new Image(argv[1], superpixels));
     }
-    Image image(argv[1], std::stoi(argv[2]));
+    catch (std::exception& e)
+    {
+        std::cerr << "Cannot read " << argv[1] << ": " << e.what() << std::endl;
+        return STATUS_INPUT;
+    }
+    std::cout << "Generated " << image->getSuperpixelCount() << " superpixels." << std::endl;
 
-    Mat img = imread("superpixels_avgcolor.png");
-    namedWindow("Select master nodes");
-    setMouseCallback("Select master nodes", onMouse, 0);
-    imshow("Select master nodes", img);
-    waitKey(0);
-    cvDestroyWindow("Select master nodes");
-    
     std::vector<Graph::vertex_descriptor> master_nodes;
-    for (auto xy : master_pixels)
+    if (interactive)
     {
-        Graph::vertex_descriptor superpixel = image.pixelToSuperpixel(xy.first, xy.second);
-        if (std::find(master_nodes.begin(), master_nodes.end(), superpixel) == master_nodes.end())
+        Mat img = imread(image->outputPath("superpixels_avgcolor.png"));
+        namedWindow("Select master nodes");
+        setMouseCallback("Select master nodes", onMouse, 0);
+        imshow("Select master nodes", img);
+        waitKey(0);
+        cvDestroyWindow("Select master nodes");
+
+        for (auto xy : master_pixels)
         {
-            master_nodes.push_back(superpixel);
+            seeds.pixels.push_back(xy);
         }
     }
-
-    Graph g = image.graph();
-    size_t n = num_vertices(g);
-    std::vector<std::set<Graph::vertex_descriptor>> initial_segments;
-    for (size_t i = 1; i < master_nodes.size(); ++i)
+    if (!masterNodesFromSeeds(seeds, *image, master_nodes))
     {
-        std::set<Graph::vertex_descriptor> segment;
-        segment.insert(master_nodes[i]);
-        initial_segments.push_back(segment);
+        return STATUS_INPUT;
     }
-    std::set<Graph::vertex_descriptor> segment;
-    for (uint32_t i = 0; i < n; ++i)
+    if (master_nodes.empty())
     {
-        if (i == master_nodes[0])
-        {
-            segment.insert(i);
-        }
-        else if (std::find(master_nodes.begin(), master_nodes.end(), i) == master_nodes.end())
-        {
-            segment.insert(i);
-        }
+        std::cerr << "No master nodes selected" << std::endl;
+        return STATUS_INPUT;
     }
-    initial_segments.push_back(segment);
-
-    std::cout << "Selecting " << initial_segments.size() << " segments" << std::endl;
 
-    std::vector<std::vector<Graph::vertex_descriptor>> segments; // the selected segments will be stored in here
-    SCIP_CALL(master_problem(g, master_nodes, initial_segments, segments));
-    image.writeSegments(master_nodes, segments, g);
+    RunStats stats;
+    ExitStatus status = segmentImage(*image, master_nodes, options, false, stats);
+    if (!report.empty())
+    {
+        stats.writeJson(report);
+    }
+    if (status != STATUS_OK)
+    {
+        return status;
+    }
 
-    img = imread("segments.png");
-    namedWindow("Selected segments");
-    imshow("Selected segments", img);
-    waitKey(0);
-    cvDestroyWindow("Selected segments");
+    if (interactive)
+    {
+        Mat img = imread(image->outputPath("segments.png"));
+        namedWindow("Selected segments");
+        imshow("Selected segments", img);
+        waitKey(0);
+        cvDestroyWindow("Selected segments");
+    }
 
-    return 0;
+    return STATUS_OK;
 }
@@ -0,0 +1,337 @@
+#include <boost/graph/connected_components.hpp>
+#include <scip/scipdefplugins.h>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <queue>
+#include <tuple>
+#include "master.h"
+#include "pricer.h"
+#include "vardata.h"
+#include "assignment_cons.h"
+#include "assignment_branching.h"
+#include "rounding_heur.h"
+
+std::vector<std::set<Graph::vertex_descriptor>> initialSegments(
+    const std::vector<Graph::vertex_descriptor>& master_nodes,
+    size_t n
+    )
+{
+    std::vector<std::set<Graph::vertex_descriptor>> initial_segments;
+    for (size_t i = 1; i < master_nodes.size(); ++i)
+    {
+        std::set<Graph::vertex_descriptor> segment;
+        segment.insert(master_nodes[i]);
+        initial_segments.push_back(segment);
+    }
+    std::set<Graph::vertex_descriptor> segment;
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        if (i == master_nodes[0])
+        {
+            segment.insert(i);
+        }
+        else if (std::find(master_nodes.begin(), master_nodes.end(), i) == master_nodes.end())
+        {
+            segment.insert(i);
+        }
+    }
+    initial_segments.push_back(segment);
+    return initial_segments;
+}
+
+std::vector<std::vector<Graph::vertex_descriptor>> growSegments(
+    const CsrGraph& g,
+    const std::vector<Graph::vertex_descriptor>& master_nodes
+    )
+{
+    std::vector<std::vector<Graph::vertex_descriptor>> segments;
+    for (auto t : master_nodes)
+    {
+        segments.push_back(std::vector<Graph::vertex_descriptor>(1, t));
+    }
+    completeSegments(g, master_nodes, segments);
+    return segments;
+}
+
+bool completeSegments(
+    const CsrGraph& g,
+    const std::vector<Graph::vertex_descriptor>& master_nodes,
+    std::vector<std::vector<Graph::vertex_descriptor>>& segments
+    )
+{
+    typedef std::tuple<SCIP_Real, uint32_t, uint32_t> Candidate; // tuple<color distance, superpixel, index of the master node>
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> frontier;
+    std::vector<int> owner(g.numVertices(), -1);
+    auto push_neighbours = [&](uint32_t s, uint32_t i) {
+        Graph::vertex_descriptor t = master_nodes[i];
+        for (const uint32_t* w = g.neighboursBegin(s); w != g.neighboursEnd(s); ++w)
+        {
+            if (owner[*w] == -1)
+            {
+                frontier.push(Candidate(std::abs(g.color(t) - g.color(*w)), *w, i));
+            }
+        }
+    };
+    size_t assigned = 0;
+    for (size_t i = 0; i < segments.size(); ++i)
+    {
+        for (auto s : segments[i])
+        {
+            owner[s] = i;
+        }
+        assigned += segments[i].size();
+    }
+    for (size_t i = 0; i < segments.size(); ++i)
+    {
+        for (auto s : segments[i])
+        {
+            push_neighbours(s, i);
+        }
+    }
+    while (!frontier.empty())
+    {
+        Candidate top = frontier.top();
+        frontier.pop();
+        uint32_t s = std::get<1>(top);
+        if (owner[s] == -1)
+        {
+            owner[s] = std::get<2>(top);
+            segments[std::get<2>(top)].push_back(s);
+            ++assigned;
+            push_neighbours(s, std::get<2>(top));
+        }
+    }
+    return assigned == g.numVertices();
+}
+
+SCIP_RETCODE createMasterProblem(
+    SCIP* scip,
+    Graph& g,
+    const CsrGraph& csr,
+    const std::vector<Graph::vertex_descriptor>& master_nodes,
+    const std::vector<std::set<Graph::vertex_descriptor>>& initial_segments,
+    const SolverOptions& options,
+    RunStats& stats,
+    SegmentPricer** pricer
+    )
+{
+    //create master problem
+    SCIP_CALL(SCIPcreateProb(scip, "master_problem", NULL, NULL, NULL, NULL, NULL, NULL, NULL));
+    SCIP_CALL(SCIPsetObjsense(scip, SCIP_OBJSENSE_MINIMIZE));
+    
+    std::vector<SCIP_VAR*> vars;
+    // vars[i] belongs to segment initial_segments[i]
+    for (auto segment : initial_segments)
+    {
+        SCIP_VAR* var;
+        // Set a very high objective value for the initial segments so that they aren't selected in the final solution
+        SCIP_CALL(SCIPcreateVar(scip, &var, "x_P", 0.0, 1.0, 10000, SCIP_VARTYPE_BINARY, TRUE, FALSE, NULL, NULL, NULL, NULL, NULL));
+        SCIP_CALL(SCIPaddVar(scip, var));
+        vars.push_back(var);
+    }
+    
+    std::vector<SCIP_CONS*> partitioning_cons;
+    for (auto p = vertices(g); p.first != p.second; ++p.first)
+    {
+        SCIP_CONS* cons1;
+        SCIP_CALL(SCIPcreateConsLinear(scip, & cons1, "first", 0, NULL, NULL, 1.0, 1.0,
+                     true,                   /* initial */
+                     false,                  /* separate */
+                     true,                   /* enforce */
+                     true,                   /* check */
+                     true,                   /* propagate */
+                     false,                  /* local */
+                     true,                   /* modifiable */
+                     false,                  /* dynamic */
+                     false,                  /* removable */
+                     false) );               /* stickingatnode */
+        for (size_t i = 0; i != initial_segments.size(); ++i)
+        {
+            if (initial_segments[i].find(*p.first) != initial_segments[i].end())
+            {
+                SCIP_CALL(SCIPaddCoefLinear(scip, cons1, vars[i], 1.0));
+            }
+        }
+        SCIP_CALL(SCIPaddCons(scip, cons1));
+        partitioning_cons.push_back(cons1);
+    }
+    
+    SCIP_CONS* num_segments_cons;
+    size_t k = initial_segments.size();
+    SCIP_CALL(SCIPcreateConsLinear(scip, &num_segments_cons, "second", 0, NULL, NULL, k, k,
+                     true,                   /* initial */
+                     false,                  /* separate */
+                     true,                   /* enforce */
+                     true,                   /* check */
+                     true,                   /* propagate */
+                     false,                  /* local */
+                     true,                   /* modifiable */
+                     false,                  /* dynamic */
+                     false,                  /* removable */
+                     false) );               /* stickingatnode */
+    for (size_t i = 0; i != initial_segments.size(); ++i)
+    {
+        SCIP_CALL(SCIPaddCoefLinear(scip, num_segments_cons, vars[i], 1.0));
+    }
+    SCIP_CALL(SCIPaddCons(scip, num_segments_cons));
+    
+    // include the branching on superpixel assignments, whose decisions the pricer respects
+    SCIP_CALL(SCIPincludeObjConshdlr(scip, new AssignmentCons(scip), TRUE));
+    SCIP_CALL(SCIPincludeObjBranchrule(scip, new AssignmentBranching(scip, num_vertices(g), master_nodes), TRUE));
+
+    // include pricer 
+    *pricer = new SegmentPricer(scip, csr, master_nodes, partitioning_cons, num_segments_cons, stats);
+    SCIP_CALL(SCIPincludeObjPricer(scip, *pricer, true));
+    SCIP_CALL(SCIPsetIntParam(scip, "pricers/fitting_pricer/threads", options.threads));
+    SCIP_CALL(SCIPsetRealParam(scip, "pricers/fitting_pricer/smoothing", options.smoothing));
+    SCIP_CALL(SCIPsetRealParam(scip, "pricers/fitting_pricer/gaptol", options.gap_tolerance));
+    SCIP_CALL(SCIPsetIntParam(scip, "pricers/fitting_pricer/engine", options.pricing_engine));
+    SCIP_CALL(SCIPsetBoolParam(scip, "pricers/fitting_pricer/validate", options.validate_pricing));
+    SCIP_CALL(SCIPincludeObjHeur(scip, new RoundingHeur(scip, csr, master_nodes, **pricer, stats), TRUE));
+    
+    if (options.grow_segments)
+    {
+        auto segments = growSegments(csr, master_nodes);
+        for (size_t i = 0; i < master_nodes.size(); ++i)
+        {
+            SCIP_CALL((*pricer)->addInitialSegment(scip, master_nodes[i], segments[i]));
+        }
+    }
+    
+    // activate pricer 
+    SCIP_CALL(SCIPactivatePricer(scip, SCIPfindPricer(scip, "fitting_pricer")));
+
+    return SCIP_OKAY;
+}
+
+/**
+ * Sets up and solves the master problem in a SCIP instance created by `master_problem`, see there
+ */
+static SCIP_RETCODE solveMasterProblem(
+    SCIP* scip,
+    Graph& g,
+    const CsrGraph& csr,
+    const std::vector<Graph::vertex_descriptor>& master_nodes,
+    const std::vector<std::set<Graph::vertex_descriptor>>& initial_segments,
+    std::vector<std::vector<Graph::vertex_descriptor>>& segments,
+    const SolverOptions& options,
+    bool quiet,
+    RunStats& stats
+    )
+{
+    typedef std::chrono::steady_clock Clock;
+    auto start = Clock::now();
+    SCIP_CALL(SCIPincludeDefaultPlugins(scip));
+    SCIP_CALL(SCIPsetIntParam(scip, "display/verblevel", 5));
+    if (quiet)
+    {
+        SCIPsetMessagehdlrQuiet(scip, TRUE);
+    }
+    SCIP_CALL(SCIPsetIntParam(scip, "presolving/maxrestarts", 0)); // see Known Bugs at http://scip.zib.de/#contact
+    
+    SegmentPricer* pricer;
+    SCIP_CALL(createMasterProblem(scip, g, csr, master_nodes, initial_segments, options, stats, &pricer));
+    stats.phases.setup = std::chrono::duration<double>(Clock::now() - start).count();
+
+    // solve
+    start = Clock::now();
+    SCIP_RETCODE retcode = SCIPsolve(scip);
+    stats.phases.solve = std::chrono::duration<double>(Clock::now() - start).count();
+    SCIP_CALL(retcode);
+    stats.columns = SCIPgetNVars(scip);
+    stats.branchings = static_cast<AssignmentBranching*>(SCIPfindObjBranchrule(scip, "assignment"))->getBranchings();
+    stats.assignment_fixings = static_cast<AssignmentCons*>(SCIPfindObjConshdlr(scip, "assignment"))->getPropFixings();
+    SCIP_SOL* sol = SCIPgetBestSol(scip);
+
+    // return selected segments
+    SCIP_VAR** variables = SCIPgetVars(scip);
+    for (int i = 0; i < SCIPgetNVars(scip); ++i)
+    {
+        if (SCIPisEQ(scip, SCIPgetSolVal(scip, sol, variables[i]), 1.0))
+        {
+            ObjVardataSegment* vardata = getSegmentVardata(scip, variables[i]);
+            if (vardata == NULL)
+            {
+                // the artificial columns only make the first master LP feasible
+                SCIPerrorMessage("the best solution still contains an artificial segment\n");
+                return SCIP_INVALIDRESULT;
+            }
+            segments.push_back(std::vector<Graph::vertex_descriptor>(vardata->begin(), vardata->end()));
+        }
+    }
+
+    // check if the selected segments are connected
+    for (auto segment : segments)
+    {
+        Graph& subgraph = g.create_subgraph();
+        std::vector<int> component(num_vertices(g));
+        for (auto superpixel : segment)
+        {
+            add_vertex(superpixel, subgraph);
+        }
+        assert(connected_components(subgraph, &component[0]) == 1);
+    }
+
+    return SCIP_OKAY;
+}
+
+SCIP_RETCODE master_problem(
+    Graph& g,
+    const CsrGraph& csr,
+    std::vector<Graph::vertex_descriptor> master_nodes,
+    std::vector<std::set<Graph::vertex_descriptor>> initial_segments,
+    std::vector<std::vector<Graph::vertex_descriptor>>& segments,
+    const SolverOptions& options,
+    bool quiet,
+    RunStats& stats
+    )
+{
+    SCIP* scip;
+    SCIP_CALL(SCIPcreate(& scip));
+
+    // free the SCIP instance even if solving fails, batch runs continue with the next image
+    SCIP_RETCODE retcode = solveMasterProblem(scip, g, csr, master_nodes, initial_segments, segments, options, quiet, stats);
+    SCIP_RETCODE free_retcode = SCIPfree(&scip);
+    SCIP_CALL(retcode);
+    return free_retcode;
+}
+
+ExitStatus segmentImage(
+    Image& image,
+    const std::vector<Graph::vertex_descriptor>& master_nodes,
+    const SolverOptions& options,
+    bool quiet,
+    RunStats& stats
+    )
+{
+    stats.image = image.getFilename();
+    stats.superpixels = image.getSuperpixelCount();
+    stats.phases.load = image.getLoadTime();
+    stats.phases.slic = image.getSlicTime();
+
+    typedef std::chrono::steady_clock Clock;
+    auto start = Clock::now();
+    Graph g = image.graph(options.threads);
+    CsrGraph csr(g);
+    auto initial_segments = initialSegments(master_nodes, num_vertices(g));
+    stats.phases.graph = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<std::vector<Graph::vertex_descriptor>> segments; // the selected segments will be stored in here
+    SCIP_RETCODE retcode = master_problem(g, csr, master_nodes, initial_segments, segments, options, quiet, stats);
+    if (retcode != SCIP_OKAY)
+    {
+        SCIPprintError(retcode);
+        return STATUS_SOLVER;
+    }
+
+    start = Clock::now();
+    if (!quiet)
+    {
+        std::cout << "write " << image.outputPath("segments.png") << std::endl;
+    }
+    image.writeSegments(master_nodes, segments, g, options.threads);
+    stats.phases.render = std::chrono::duration<double>(Clock::now() - start).count();
+    return STATUS_OK;
+}
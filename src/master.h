@@ -0,0 +1,117 @@
+#ifndef MASTER_H
+#define MASTER_H
+
+#include <set>
+#include <vector>
+#include <scip/scip.h>
+#include "graph.h"
+#include "csr_graph.h"
+#include "image.h"
+#include "stats.h"
+
+class SegmentPricer;
+
+/**
+ * Exit codes of the program
+ */
+enum ExitStatus
+{
+    STATUS_OK = 0, ///< the segmentation was written
+    STATUS_USAGE = 1, ///< invalid command line
+    STATUS_INPUT = 2, ///< the image or the master nodes could not be read
+    STATUS_SOLVER = 3 ///< SCIP reported an error
+};
+
+/**
+ * Options of the column generation given on the command line
+ */
+struct SolverOptions
+{
+    int threads = 1; ///< number of threads used to build the graph, solve the pricing problems and render the result
+    SCIP_Real smoothing = 0.0; ///< dual smoothing factor of the pricer, see `pricers/fitting_pricer/smoothing`
+    SCIP_Real gap_tolerance = 0.0; ///< relative gap at which the pricing stops, see `pricers/fitting_pricer/gaptol`
+    int pricing_engine = 0; ///< method of solving the pricing problems exactly, see `pricers/fitting_pricer/engine`
+    bool validate_pricing = false; ///< check the combinatorial pricing against the pricing SCIP, see `pricers/fitting_pricer/validate`
+    bool grow_segments = true; ///< start the column generation with the segments of `growSegments`
+};
+
+/**
+ * Creates the initial segments for the master problem
+ * Every master node except the first one forms a segment on its own, all remaining superpixels
+ * are put into the segment of the first master node. This is a feasible, but in general not connected, partition.
+ */
+std::vector<std::set<Graph::vertex_descriptor>> initialSegments(
+    const std::vector<Graph::vertex_descriptor>& master_nodes, ///< master nodes of all segments, must not be empty
+    size_t n ///< number of superpixels
+    );
+
+/**
+ * Grows the segments of all master nodes simultaneously
+ * Starting from the master nodes, the superpixel with the smallest color distance \f$|y_t-y_s|\f$ to the master node \f$t\f$
+ * of an adjacent segment is added to that segment, until every superpixel reachable from a master node belongs to a segment.
+ * The resulting segments are connected and disjoint, so they are a segmentation if the graph is connected.
+ * @return the superpixels of the segment of each master node, in the order of `master_nodes`
+ */
+std::vector<std::vector<Graph::vertex_descriptor>> growSegments(
+    const CsrGraph& g, ///< the graph of superpixels
+    const std::vector<Graph::vertex_descriptor>& master_nodes ///< master nodes of all segments
+    );
+
+/**
+ * Grows given segments like `growSegments` until every superpixel reachable from them belongs to a segment
+ * Connected segments stay connected, since only adjacent superpixels are added.
+ * @return whether every superpixel belongs to a segment afterwards
+ */
+bool completeSegments(
+    const CsrGraph& g, ///< the graph of superpixels
+    const std::vector<Graph::vertex_descriptor>& master_nodes, ///< master nodes of all segments
+    std::vector<std::vector<Graph::vertex_descriptor>>& segments ///< disjoint segments, `segments[i]` must contain `master_nodes[i]`
+    );
+
+/**
+ * Creates the master problem with the initial segments as variables and includes and activates the pricer
+ * If `options.grow_segments` is set, the segments of `growSegments` are added as segment variables with their actual costs,
+ * so that the first master LP already has a solution of realistic costs.
+ */
+SCIP_RETCODE createMasterProblem(
+    SCIP* scip, ///< master SCIP instance with the default plugins included
+    Graph& g, ///< the graph of superpixels
+    const CsrGraph& csr, ///< the graph of superpixels in the compact format used by the pricer
+    const std::vector<Graph::vertex_descriptor>& master_nodes, ///< master nodes of all segments
+    const std::vector<std::set<Graph::vertex_descriptor>>& initial_segments, ///< an initial set of segments that will be added as variables
+    const SolverOptions& options, ///< the parameters of the pricer are set from these
+    RunStats& stats, ///< the pricer records its statistics in here
+    SegmentPricer** pricer ///< pointer to store the pricer, which is owned by `scip`
+    );
+
+/**
+ * Setup and solve the master problem
+ * Every call creates and frees its own SCIP instance, so several master problems can be solved concurrently.
+ */
+SCIP_RETCODE master_problem(
+    Graph& g, ///< the graph of superpixels
+    const CsrGraph& csr, ///< the graph of superpixels in the compact format used by the pricer
+    std::vector<Graph::vertex_descriptor> master_nodes, ///< master nodes of all segments 
+    std::vector<std::set<Graph::vertex_descriptor>> initial_segments, ///< an initial set of segments that will be added as variables
+                                                                      ///< These should form a feasible solution, but do not need to be connected.
+    std::vector<std::vector<Graph::vertex_descriptor>>& segments, ///< the selected segments will be stored in here
+    const SolverOptions& options, ///< the parameters of the pricer are set from these
+    bool quiet, ///< suppress the output of SCIP
+    RunStats& stats ///< the setup and solve times and the statistics of the pricer are stored in here
+    );
+
+/**
+ * Segments an image whose superpixels have already been computed and writes the result
+ * This builds the graph of superpixels, solves the master problem and writes `segments.png`
+ * to the output path of the image.
+ * @return `STATUS_OK`, or `STATUS_SOLVER` if SCIP reported an error
+ */
+ExitStatus segmentImage(
+    Image& image, ///< the image with its superpixels
+    const std::vector<Graph::vertex_descriptor>& master_nodes, ///< master nodes of all segments, must not be empty
+    const SolverOptions& options,
+    bool quiet, ///< suppress the output of SCIP
+    RunStats& stats ///< the times of all phases and the solver statistics are stored in here
+    );
+
+#endif
@@ -3,20 +3,72 @@
 #include <scip/cons_linear.h>
 #include <boost/graph/adjacency_list.hpp>
 #include "graph.h"
+#include <boost/dynamic_bitset.hpp>
 #include <algorithm>
+#include <chrono>
+#include <climits>
+#include <functional>
 #include <iostream>
+#include <iterator>
+#include <mutex>
 #include <cmath>
+#include <queue>
 
 #include "pricer.h"
 #include "vardata.h"
 #include "connectivity_cons.h"
+#include "assignment_cons.h"
 
 using namespace scip;
 
-SegmentPricer::SegmentPricer(SCIP* scip, Graph& g_, std::vector<Graph::vertex_descriptor> master_nodes_, std::vector<SCIP_CONS*> partitioning_cons_, SCIP_CONS* num_segments_cons_) :
+/** serializes the validation messages of pricers running in concurrent batch jobs */
+static std::mutex output_mutex;
+
+SegmentPricer::SegmentPricer(SCIP* scip, const CsrGraph& g_, std::vector<Graph::vertex_descriptor> master_nodes_, std::vector<SCIP_CONS*> partitioning_cons_, SCIP_CONS* num_segments_cons_, RunStats& stats_) :
     ObjPricer(scip, "fitting_pricer", "description", 0, TRUE),
-    g(g_), master_nodes(master_nodes_), partitioning_cons(partitioning_cons_), num_segments_cons(num_segments_cons_)
-{}
+    g(g_), master_nodes(master_nodes_), partitioning_cons(partitioning_cons_), num_segments_cons(num_segments_cons_), stats(stats_)
+{
+    SCIP_CALL_ABORT(SCIPaddIntParam(scip, "pricers/fitting_pricer/threads",
+        "number of threads used to solve the pricing problems concurrently (1: sequential)",
+        &threads, FALSE, 1, 1, 256, NULL, NULL));
+    SCIP_CALL_ABORT(SCIPaddBoolParam(scip, "pricers/fitting_pricer/reuse",
+        "start from the previous optimal segment when solving a pricing problem again",
+        &reuse, FALSE, TRUE, NULL, NULL));
+    SCIP_CALL_ABORT(SCIPaddBoolParam(scip, "pricers/fitting_pricer/cutoff",
+        "stop each exact pricing solve as soon as no segment with negative reduced costs can exist",
+        &cutoff, FALSE, TRUE, NULL, NULL));
+    SCIP_CALL_ABORT(SCIPaddIntParam(scip, "pricers/fitting_pricer/cutpoolsize",
+        "maximum number of components whose connectivity cuts are shared by all pricing problems (0: no cut pool)",
+        &cut_pool_size, FALSE, 10000, 0, INT_MAX, NULL, NULL));
+    SCIP_CALL_ABORT(SCIPaddIntParam(scip, "pricers/fitting_pricer/cutpoolage",
+        "number of pricing rounds after which unused connectivity cuts are removed from the cut pool",
+        &cut_pool_age, FALSE, 10, 1, INT_MAX, NULL, NULL));
+    SCIP_CALL_ABORT(SCIPaddRealParam(scip, "pricers/fitting_pricer/smoothing",
+        "Wentges smoothing factor of the duals the pricing problems are solved for (0: no stabilization)",
+        &smoothing, FALSE, 0.0, 0.0, 0.99, NULL, NULL));
+    SCIP_CALL_ABORT(SCIPaddRealParam(scip, "pricers/fitting_pricer/gaptol",
+        "relative gap between the master LP value and the Lagrangian bound at which the pricing stops (0: solve the LP to optimality)",
+        &gap_tolerance, FALSE, 0.0, 0.0, 1.0, NULL, NULL));
+    SCIP_CALL_ABORT(SCIPaddIntParam(scip, "pricers/fitting_pricer/maxcolumns",
+        "maximum number of segments added per master node and pricing round",
+        &max_columns, FALSE, 3, 1, 1000, NULL, NULL));
+    SCIP_CALL_ABORT(SCIPaddRealParam(scip, "pricers/fitting_pricer/diversity",
+        "minimum fraction of superpixels in which two segments of the same master node added in one round differ",
+        &diversity, FALSE, 0.2, 0.0, 1.0, NULL, NULL));
+    SCIP_CALL_ABORT(SCIPaddBoolParam(scip, "pricers/fitting_pricer/poolpricing",
+        "price the segments already generated before solving the pricing problems",
+        &pool_pricing, FALSE, TRUE, NULL, NULL));
+    SCIP_CALL_ABORT(SCIPaddIntParam(scip, "pricers/fitting_pricer/engine",
+        "method of solving the pricing problems exactly (0: pricing SCIP, 1: combinatorial branch-and-bound with the pricing SCIP as fallback)",
+        &engine, FALSE, 0, 0, 1, NULL, NULL));
+    SCIP_CALL_ABORT(SCIPaddIntParam(scip, "pricers/fitting_pricer/bbnodes",
+        "node limit of the combinatorial branch-and-bound, the pricing SCIP is solved if it is reached",
+        &bb_node_limit, FALSE, 10000, 1, INT_MAX, NULL, NULL));
+    SCIP_CALL_ABORT(SCIPaddBoolParam(scip, "pricers/fitting_pricer/validate",
+        "solve the pricing SCIP after the combinatorial branch-and-bound and report different optimal values",
+        &validate, FALSE, FALSE, NULL, NULL));
+    column_pool.reset(new ColumnPool());
+}
 
 SCIP_DECL_PRICERINIT(SegmentPricer::scip_init)
 {
@@ -27,24 +79,70 @@ SCIP_DECL_PRICERINIT(SegmentPricer::scip_init)
     SCIP_CALL(SCIPgetTransformedCons(scip, num_segments_cons, &num_segments_cons));
     
     _bigM = 0;
-    for (auto p = vertices(g); p.first != p.second; ++p.first)
+    for (size_t s = 0; s < g.numVertices(); ++s)
     {
-        if (g[*p.first].color > _bigM)
+        if (g.color(s) > _bigM)
         {
-            _bigM = g[*p.first].color;
+            _bigM = g.color(s);
         }
     }
-    _n = num_vertices(g);
+    _n = g.numVertices();
+    mu.resize(_n);
+    lp_mu.resize(_n);
+    center_mu.clear();
+    center_bound = -SCIPinfinity(scip);
+    center_node = -1;
+    stats.smoothing = smoothing;
+    master_mask.resize(_n);
+    for (auto t : master_nodes)
+    {
+        master_mask.set(t);
+    }
+    pricing_results.resize(master_nodes.size());
+    pool.reset(new ThreadPool(threads));
+    cut_pool.reset(new CutPool(cut_pool_size, cut_pool_age));
+    for (auto& var : column_vars)
+    {
+        SCIP_CALL(SCIPgetTransformedVar(scip, var, &var));
+    }
+    master_index.assign(_n, 0);
+    for (size_t i = 0; i < master_nodes.size(); ++i)
+    {
+        master_index[master_nodes[i]] = i;
+    }
+    cost_scale = 1.0;
+    assignment_cons = dynamic_cast<AssignmentCons*>(SCIPfindObjConshdlr(scip, "assignment"));
+    updateDomains();
+    stats.master_nodes.resize(master_nodes.size());
+    for (size_t i = 0; i < master_nodes.size(); ++i)
+    {
+        stats.master_nodes[i].superpixel = master_nodes[i];
+    }
     
+    subgraph_solvers.clear();
+    for (size_t i = 0; i < master_nodes.size(); ++i)
+    {
+        subgraph_solvers.emplace_back(new ConnectedSubgraphSolver(g));
+        for (auto t : master_nodes)
+        {
+            if (t != master_nodes[i])
+            {
+                subgraph_solvers[i]->forbid(t);
+            }
+        }
+    }
+
     scip_pricers.resize(master_nodes.size());
+    conshdlrs.resize(master_nodes.size());
+    last_segments.assign(master_nodes.size(), std::vector<Graph::vertex_descriptor>());
+    start_segments.assign(master_nodes.size(), std::vector<std::vector<Graph::vertex_descriptor>>());
     for (size_t i = 0; i < master_nodes.size(); ++i)
     {
         auto probdata = new PricerData();
 
         SCIP_CALL(SCIPcreate(&scip_pricers[i]));
-        SCIP_CALL(SCIPincludeObjConshdlr(scip_pricers[i],
-            new ConnectivityCons(scip_pricers[i], g, master_nodes, master_nodes[i], probdata->x),
-            TRUE));
+        conshdlrs[i] = new ConnectivityCons(scip_pricers[i], g, master_mask, master_nodes[i], probdata->x, *cut_pool);
+        SCIP_CALL(SCIPincludeObjConshdlr(scip_pricers[i], conshdlrs[i], TRUE));
         SCIP_CALL(SCIPincludeDefaultPlugins(scip_pricers[i]));
         SCIPsetMessagehdlrQuiet(scip_pricers[i], TRUE);
 
@@ -67,16 +165,16 @@ SCIP_RETCODE SegmentPricer::setupVars(SCIP* scip_pricer, Graph::vertex_descripto
 {
     auto probdata = (PricerData*) SCIPgetObjProbData(scip_pricer);
 
-    for (auto p = vertices(g); p.first != p.second; ++p.first)
+    for (size_t s = 0; s < g.numVertices(); ++s)
     {
         SCIP_Real mu_s = 0.0; // random value, is set to the correct one at each iteration
         SCIP_VAR* x_s;
         SCIP_CALL(SCIPcreateVar(scip_pricer, & x_s, "x_s", 0.0, 1.0, -mu_s, SCIP_VARTYPE_BINARY, TRUE, FALSE, NULL, NULL, NULL, NULL, NULL));
-        if (*p.first == t)
+        if (s == t)
         {
             SCIP_CALL(SCIPchgVarLb(scip_pricer, x_s, 1.0));
         }
-        else if (std::find(master_nodes.begin(), master_nodes.end(), *p.first) != master_nodes.end())
+        else if (master_mask[s])
         {
             // if a superpixel s is in T\{t}, then x_s must be 0
             SCIP_CALL(SCIPchgVarUb(scip_pricer, x_s, 0.0));
@@ -89,32 +187,109 @@ SCIP_RETCODE SegmentPricer::setupVars(SCIP* scip_pricer, Graph::vertex_descripto
 
 SCIP_DECL_PRICERREDCOST(SegmentPricer::scip_redcost)
 {
-    SCIP_Real lambda = SCIPgetDualsolLinear(scip, num_segments_cons);
-    
-    for (size_t i = 0; i < master_nodes.size(); ++i)
+    ++stats.pricing_rounds;
+    SCIP_Real lp_value = SCIPgetLPObjval(scip);
+    stats.lp_bounds.push_back(LpBound{stats.pricing_rounds, SCIPgetSolvingTime(scip), lp_value, std::nan("")});
+
+    // take a snapshot of the dual values, the pricing problems only read from it
+    SCIP_Real lp_lambda = SCIPgetDualsolLinear(scip, num_segments_cons);
+    for (size_t s = 0; s < g.numVertices(); ++s)
     {
-        auto p = heuristic(scip, master_nodes[i], lambda); // returns pair<redcost, superpixels>
-        if (SCIPisDualfeasNegative(scip, p.first))
+        lp_mu[s] = SCIPgetDualsolLinear(scip, partitioning_cons[s]);
+    }
+    updateDomains();
+    pricePool(scip);
+
+    bool smoothed = smoothing > 0.0 && !center_mu.empty();
+    SCIP_Real lambda = lp_lambda;
+    if (smoothed)
+    {
+        for (size_t s = 0; s < g.numVertices(); ++s)
         {
-            std::cout << "heuristic successful: " << p.second.size() << std::endl;
-            std::cout << "reduced costs: " << p.first << std::endl;
-            SCIP_CALL(addPartitionVar(scip, master_nodes[i], p.second));
+            mu[s] = smoothing * center_mu[s] + (1.0 - smoothing) * lp_mu[s];
         }
-        else
+        lambda = smoothing * center_lambda + (1.0 - smoothing) * lp_lambda;
+    }
+    else
+    {
+        mu = lp_mu;
+    }
+    SCIP_CALL(solvePricingProblems(scip, lambda));
+
+    // the Lagrangian bound is valid for every dual point, smoothed or not
+    SCIP_Real best_bound = lagrangianBound(scip, lambda);
+    updateCenter(scip, lambda, best_bound);
+
+    // the reduced costs with respect to the duals of the master LP differ by the change of the duals
+    bool improving = false;
+    for (auto& r : pricing_results)
+    {
+        improving = improving || !r.pool_columns.empty();
+        for (auto& column : r.columns)
         {
-            auto probdata = (PricerData*) SCIPgetObjProbData(scip_pricers[i]);
-            SCIP_CALL(SCIPfreeTransform(scip_pricers[i])); // reset transformation, solution data and SCIP stage
-            for (auto s = vertices(g); s.first != s.second; ++s.first)
+            column.lp_redcost = column.redcost + lambda - lp_lambda;
+            for (auto s : column.superpixels)
             {
-                SCIP_Real mu_s = SCIPgetDualsolLinear(scip, partitioning_cons[*s.first]);
-                SCIP_CALL(SCIPchgVarObj(scip_pricers[i], probdata->x[*s.first], -mu_s + std::abs(g[master_nodes[i]].color - g[*s.first].color)));
+                column.lp_redcost += mu[s] - lp_mu[s];
             }
-            SCIP_CALL(SCIPsolve(scip_pricers[i]));
-            SCIP_SOL* sol = SCIPgetBestSol(scip_pricers[i]);
-            if (SCIPisDualfeasNegative(scip, SCIPgetSolOrigObj(scip_pricers[i], sol) - lambda))
+            improving = improving || SCIPisDualfeasNegative(scip, column.lp_redcost);
+        }
+    }
+    if (smoothed && !improving)
+    {
+        // mispricing, the smoothed duals are no proof that the master LP is optimal
+        ++stats.mispricings;
+        mu = lp_mu;
+        lambda = lp_lambda;
+        SCIP_CALL(solvePricingProblems(scip, lambda));
+        for (auto& r : pricing_results)
+        {
+            for (auto& column : r.columns)
             {
-                //TODO compare SolOrigObj to sum -mu_s + |y_t - y_s|
-                SCIP_CALL(addPartitionVarFromPricerSCIP(scip, scip_pricers[i], sol, master_nodes[i]));
+                column.lp_redcost = column.redcost;
+            }
+        }
+        SCIP_Real bound = lagrangianBound(scip, lambda);
+        best_bound = std::max(best_bound, bound);
+        updateCenter(scip, lambda, bound);
+    }
+    // share the connectivity cuts found in this round, including Farkas pricing, with all pricing problems
+    endCutRound();
+
+    if (!SCIPisInfinity(scip, -best_bound))
+    {
+        *lowerbound = best_bound;
+        stats.lp_bounds.back().lagrangian = best_bound;
+        if (gap_tolerance > 0.0 && SCIPrelDiff(lp_value, best_bound) <= gap_tolerance)
+        {
+            *stopearly = TRUE;
+            stats.stopped_early = true;
+        }
+    }
+
+    // add the new columns in a deterministic order
+    for (size_t i = 0; i < master_nodes.size(); ++i)
+    {
+        PricingResult& r = pricing_results[i];
+        // SCIP returns the improving problem variables of the column pool to the LP itself
+        stats.master_nodes[i].pool_columns += r.pool_columns.size();
+        for (auto& column : r.columns)
+        {
+            if (SCIPisDualfeasNegative(scip, column.lp_redcost))
+            {
+                // the message handler of the master SCIP is silenced in batch runs
+                SCIPinfoMessage(scip, NULL, "%s successful: %lu\nreduced costs: %g\n", r.by_heuristic ? "heuristic" : "pricer",
+                    (unsigned long) column.superpixels.size(), column.lp_redcost);
+                bool added;
+                SCIP_CALL(addPartitionVar(scip, master_nodes[i], column.superpixels, &added));
+                if (added)
+                {
+                    ++stats.master_nodes[i].columns;
+                }
+                else
+                {
+                    ++stats.master_nodes[i].duplicate_columns;
+                }
             }
         }
     }
@@ -123,39 +298,501 @@ SCIP_DECL_PRICERREDCOST(SegmentPricer::scip_redcost)
     return SCIP_OKAY;
 }
 
-std::pair<SCIP_Real, std::vector<Graph::vertex_descriptor>> SegmentPricer::heuristic(SCIP* scip, Graph::vertex_descriptor master_node, SCIP_Real lambda)
+SCIP_DECL_PRICERFARKAS(SegmentPricer::scip_farvar)
 {
-    std::vector<Graph::vertex_descriptor> superpixels;
-    SCIP_Real redcost = -SCIPgetDualsolLinear(scip, partitioning_cons[master_node]) - lambda;
-    superpixels.push_back(master_node);
-    while (superpixels.size() < _n - master_nodes.size() + 1)
+    ++stats.farkas_rounds;
+    SCIP_Real lambda = SCIPgetDualfarkasLinear(scip, num_segments_cons);
+    for (size_t s = 0; s < g.numVertices(); ++s)
     {
-        SCIP_Real minimum = SCIPinfinity(scip);
-        Graph::vertex_descriptor minimizer;
-        for (auto superpixel : superpixels)
+        mu[s] = SCIPgetDualfarkasLinear(scip, partitioning_cons[s]);
+    }
+    updateDomains();
+    for (auto& r : pricing_results)
+    {
+        r.pool_columns.clear();
+    }
+
+    // the segment costs do not matter for the infeasibility of the master LP
+    cost_scale = 0.0;
+    SCIP_RETCODE retcode = solvePricingProblems(scip, lambda);
+    cost_scale = 1.0;
+    SCIP_CALL(retcode);
+
+    for (size_t i = 0; i < master_nodes.size(); ++i)
+    {
+        for (auto& column : pricing_results[i].columns)
         {
-            for (auto p = out_edges(superpixel, g); p.first != p.second; ++p.first)
+            if (SCIPisDualfeasNegative(scip, column.redcost))
             {
-                assert(boost::source(*p.first, g) == superpixel);
-                Graph::vertex_descriptor target = boost::target(*p.first, g);
-                // the target should not already be in the segment
-                if (std::find(superpixels.begin(), superpixels.end(), target) == superpixels.end()
-                    && std::find(master_nodes.begin(), master_nodes.end(), target) == master_nodes.end())
+                bool added;
+                SCIP_CALL(addPartitionVar(scip, master_nodes[i], column.superpixels, &added));
+                if (added)
+                {
+                    ++stats.master_nodes[i].columns;
+                }
+                else
                 {
-                    SCIP_Real mu_s = SCIPgetDualsolLinear(scip, partitioning_cons[target]);
-                    if (SCIPisLT(scip, -mu_s + std::abs(g[master_node].color - g[target].color), minimum))
-                    {
-                        minimum = -mu_s + std::abs(g[master_node].color - g[target].color);
-                        minimizer = target;
-                    }
+                    ++stats.master_nodes[i].duplicate_columns;
                 }
             }
         }
-        if (SCIPisNegative(scip, minimum)
-            || !SCIPisDualfeasNegative(scip, redcost))
+    }
+    return SCIP_OKAY;
+}
+
+void SegmentPricer::updateDomains()
+{
+    required.assign(master_nodes.size(), dynamic_bitset<>(_n));
+    excluded.assign(master_nodes.size(), master_mask);
+    for (size_t i = 0; i < master_nodes.size(); ++i)
+    {
+        required[i].set(master_nodes[i]);
+        excluded[i].reset(master_nodes[i]);
+    }
+    if (assignment_cons != NULL)
+    {
+        for (auto& decision : assignment_cons->getActiveDecisions())
         {
-            superpixels.push_back(minimizer);
-            redcost += minimum;
+            size_t i = master_index[decision.master_node];
+            if (decision.type == AssignmentDecision::DIFFER)
+            {
+                excluded[i].set(decision.superpixel);
+                continue;
+            }
+            required[i].set(decision.superpixel);
+            for (size_t j = 0; j < master_nodes.size(); ++j)
+            {
+                if (j != i)
+                {
+                    excluded[j].set(decision.superpixel);
+                }
+            }
+        }
+    }
+    feasible_domains.resize(master_nodes.size());
+    for (size_t i = 0; i < master_nodes.size(); ++i)
+    {
+        feasible_domains[i] = !required[i].intersects(excluded[i]);
+    }
+}
+
+void SegmentPricer::pricePool(SCIP* scip)
+{
+    for (auto& r : pricing_results)
+    {
+        r.pool_columns.clear();
+    }
+    if (!pool_pricing || column_pool->size() == 0)
+    {
+        return;
+    }
+
+    pool_redcosts.resize(column_pool->size());
+    column_pool->reducedCosts(lp_mu.data(), SCIPgetDualsolLinear(scip, num_segments_cons), pool_redcosts.data());
+    for (size_t column = 0; column < column_pool->size(); ++column)
+    {
+        SCIP_VAR* var = column_vars[column];
+        size_t i = master_index[column_pool->masterNode(column)];
+        if (SCIPisDualfeasNegative(scip, pool_redcosts[column]) && !SCIPvarIsInLP(var) && SCIPvarGetUbLocal(var) > 0.5
+            && respectsDomain(i, column_pool->begin(column), column_pool->end(column)))
+        {
+            pricing_results[i].pool_columns.push_back(column);
+        }
+    }
+}
+
+SCIP_RETCODE SegmentPricer::solvePricingProblems(SCIP* scip, SCIP_Real lambda)
+{
+    if (pool->size() > 1)
+    {
+        pool->run(master_nodes.size(), [this, scip, lambda](size_t i) {
+            pricing_results[i].retcode = solvePricingProblem(scip, i, lambda);
+        });
+    }
+    else
+    {
+        for (size_t i = 0; i < master_nodes.size(); ++i)
+        {
+            pricing_results[i].retcode = solvePricingProblem(scip, i, lambda);
+        }
+    }
+
+    for (size_t i = 0; i < master_nodes.size(); ++i)
+    {
+        SCIP_CALL(pricing_results[i].retcode);
+    }
+    return SCIP_OKAY;
+}
+
+SCIP_Real SegmentPricer::lagrangianBound(SCIP* scip, SCIP_Real lambda) const
+{
+    SCIP_Real bound = master_nodes.size() * lambda;
+    for (size_t s = 0; s < g.numVertices(); ++s)
+    {
+        bound += mu[s];
+    }
+    for (size_t i = 0; i < master_nodes.size(); ++i)
+    {
+        if (SCIPisInfinity(scip, -pricing_results[i].lower_bound))
+        {
+            return -SCIPinfinity(scip);
+        }
+        bound += std::min(0.0, pricing_results[i].lower_bound);
+    }
+    return bound;
+}
+
+void SegmentPricer::updateCenter(SCIP* scip, SCIP_Real lambda, SCIP_Real bound)
+{
+    if (smoothing <= 0.0)
+    {
+        return;
+    }
+    // the bounds of the parent node are not comparable, but its center is a good start
+    SCIP_Longint node = SCIPnodeGetNumber(SCIPgetCurrentNode(scip));
+    if (node != center_node)
+    {
+        center_node = node;
+        center_bound = -SCIPinfinity(scip);
+    }
+    if (center_mu.empty() || bound > center_bound)
+    {
+        center_mu = mu;
+        center_lambda = lambda;
+        center_bound = bound;
+    }
+}
+
+void SegmentPricer::endCutRound()
+{
+    std::vector<const CutPool::RoundCuts*> reports;
+    for (size_t i = 0; i < master_nodes.size(); ++i)
+    {
+        reports.push_back(&conshdlrs[i]->getRoundCuts());
+    }
+    cut_pool->endRound(reports);
+    for (size_t i = 0; i < master_nodes.size(); ++i)
+    {
+        conshdlrs[i]->getRoundCuts().clear();
+    }
+    stats.cut_pool_size = cut_pool->size();
+}
+
+SCIP_RETCODE SegmentPricer::solvePricingProblem(SCIP* scip, size_t i, SCIP_Real lambda)
+{
+    PricingResult& r = pricing_results[i];
+    r.columns.clear();
+    if (!r.pool_columns.empty())
+    {
+        // the column pool already provides improving segments of this master node
+        r.by_heuristic = false;
+        r.lower_bound = -SCIPinfinity(scip);
+        return SCIP_OKAY;
+    }
+    if (!feasible_domains[i])
+    {
+        // the branching decisions contradict each other, no segment of this master node is allowed
+        r.by_heuristic = false;
+        r.lower_bound = SCIPinfinity(scip);
+        return SCIP_OKAY;
+    }
+
+    std::vector<std::pair<SCIP_Real, size_t>> prefixes;
+    auto p = heuristic(scip, master_nodes[i], lambda, max_columns > 1 ? &prefixes : NULL); // returns pair<redcost, superpixels>
+    if (SCIPisDualfeasNegative(scip, p.first))
+    {
+        r.by_heuristic = true;
+        r.lower_bound = -SCIPinfinity(scip);
+        std::vector<Column> candidates;
+        if (prefixes.empty())
+        {
+            candidates.push_back(Column{p.first, std::move(p.second), 0.0});
+        }
+        for (auto& prefix : prefixes)
+        {
+            candidates.push_back(Column{prefix.first,
+                std::vector<Graph::vertex_descriptor>(p.second.begin(), p.second.begin() + prefix.second), 0.0});
+        }
+        selectColumns(candidates, r.columns);
+        ++stats.master_nodes[i].heuristic_hits;
+        return SCIP_OKAY;
+    }
+    ++stats.master_nodes[i].heuristic_misses;
+    start_segments[i].clear();
+    // the segment of the failed heuristic has no negative reduced costs, the cutoff would reject it anyway
+    if (!cutoff && !SCIPisInfinity(scip, p.first))
+    {
+        start_segments[i].push_back(std::move(p.second));
+    }
+    if (engine == 1)
+    {
+        if (solveCombinatorially(scip, i, lambda))
+        {
+            if (validate)
+            {
+                PricingResult combinatorial = r;
+                SCIP_CALL(solveExactly(scip, i, lambda));
+                // with the cutoff, the pricing SCIP only proves that no segment has negative reduced costs
+                if (!SCIPisFeasEQ(scip, std::min(0.0, r.lower_bound), std::min(0.0, combinatorial.lower_bound)))
+                {
+                    ++stats.master_nodes[i].validation_mismatches;
+                    // the pricing problems of all concurrent runs report here
+                    std::lock_guard<std::mutex> lock(output_mutex);
+                    std::cerr << "combinatorial pricing of master node " << master_nodes[i] << " found " << combinatorial.lower_bound
+                        << ", the pricing SCIP found " << r.lower_bound << std::endl;
+                }
+                r = std::move(combinatorial);
+            }
+            return SCIP_OKAY;
+        }
+        ++stats.master_nodes[i].combinatorial_fallbacks;
+        auto& solutions = subgraph_solvers[i]->getSolutions();
+        if (!solutions.empty())
+        {
+            // the best segment found before the node limit was reached already has negative reduced costs
+            start_segments[i].push_back(std::vector<Graph::vertex_descriptor>(
+                solutions.back().superpixels.begin(), solutions.back().superpixels.end()));
+        }
+    }
+    return solveExactly(scip, i, lambda);
+}
+
+bool SegmentPricer::solveCombinatorially(SCIP* scip, size_t i, SCIP_Real lambda)
+{
+    ConnectedSubgraphSolver& solver = *subgraph_solvers[i];
+    Graph::vertex_descriptor t = master_nodes[i];
+    for (size_t s = 0; s < g.numVertices(); ++s)
+    {
+        solver.setWeight(s, -mu[s] + cost_scale * std::abs(g.color(t) - g.color(s)));
+    }
+    // the other master nodes are forbidden permanently
+    for (size_t s = excluded[i].find_first(); s != dynamic_bitset<>::npos; s = excluded[i].find_next(s))
+    {
+        if (!master_mask[s])
+        {
+            solver.exclude(s);
+        }
+    }
+    for (size_t s = required[i].find_first(); s != dynamic_bitset<>::npos; s = required[i].find_next(s))
+    {
+        if (s != t)
+        {
+            solver.require(s);
+        }
+    }
+    auto start = std::chrono::steady_clock::now();
+    bool solved = solver.solve(t, lambda, bb_node_limit, SCIPepsilon(scip));
+    MasterNodeStats& node_stats = stats.master_nodes[i];
+    node_stats.combinatorial_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    node_stats.combinatorial_nodes += solver.getNumNodes();
+    if (!solved)
+    {
+        return false;
+    }
+    ++node_stats.combinatorial_solves;
+
+    PricingResult& r = pricing_results[i];
+    r.by_heuristic = false;
+    r.columns.clear();
+    r.lower_bound = solver.getBestValue() - lambda;
+
+    // the improving segments found during the search, the best one first
+    std::vector<Column> candidates;
+    auto& solutions = solver.getSolutions();
+    size_t num_sols = max_columns > 1 ? solutions.size() : std::min<size_t>(solutions.size(), 1);
+    for (auto sol = solutions.rbegin(); sol != solutions.rbegin() + num_sols; ++sol)
+    {
+        SCIP_Real redcost = sol->value - lambda;
+        if (SCIPisDualfeasNegative(scip, redcost))
+        {
+            candidates.push_back(Column{redcost,
+                std::vector<Graph::vertex_descriptor>(sol->superpixels.begin(), sol->superpixels.end()), 0.0});
+        }
+    }
+    selectColumns(candidates, r.columns);
+    return true;
+}
+
+SCIP_RETCODE SegmentPricer::solveExactly(SCIP* scip, size_t i, SCIP_Real lambda)
+{
+    PricingResult& r = pricing_results[i];
+    r.by_heuristic = false;
+    r.columns.clear();
+
+    auto probdata = (PricerData*) SCIPgetObjProbData(scip_pricers[i]);
+    SCIP_CALL(SCIPfreeTransform(scip_pricers[i])); // reset transformation, solution data and SCIP stage
+    for (size_t s = 0; s < g.numVertices(); ++s)
+    {
+        SCIP_CALL(SCIPchgVarObj(scip_pricers[i], probdata->x[s], -mu[s] + cost_scale * std::abs(g.color(master_nodes[i]) - g.color(s))));
+        // the branching decisions change between calls, so the bounds are relaxed before they are tightened
+        if (excluded[i][s])
+        {
+            SCIP_CALL(SCIPchgVarLb(scip_pricers[i], probdata->x[s], 0.0));
+            SCIP_CALL(SCIPchgVarUb(scip_pricers[i], probdata->x[s], 0.0));
+        }
+        else
+        {
+            SCIP_CALL(SCIPchgVarUb(scip_pricers[i], probdata->x[s], 1.0));
+            SCIP_CALL(SCIPchgVarLb(scip_pricers[i], probdata->x[s], required[i][s] ? 1.0 : 0.0));
+        }
+    }
+    if (cutoff)
+    {
+        // only segments with negative reduced costs are of interest, SCIP stops once it proves that none exists
+        SCIP_CALL(SCIPsetObjlimit(scip_pricers[i], lambda));
+    }
+
+    // the previous optimal segment and the segments of the heuristics are still connected,
+    // SCIP evaluates them with the new objective and discards those above the cutoff
+    if (reuse && !last_segments[i].empty())
+    {
+        start_segments[i].push_back(last_segments[i]);
+    }
+    for (auto& segment : start_segments[i])
+    {
+        if (!respectsDomain(i, segment.begin(), segment.end()))
+        {
+            continue;
+        }
+        SCIP_SOL* start_sol;
+        SCIP_Bool stored;
+        SCIP_CALL(SCIPcreateOrigSol(scip_pricers[i], &start_sol, NULL));
+        for (auto s : segment)
+        {
+            SCIP_CALL(SCIPsetSolVal(scip_pricers[i], start_sol, probdata->x[s], 1.0));
+        }
+        SCIP_CALL(SCIPaddSolFree(scip_pricers[i], &start_sol, &stored));
+        stats.master_nodes[i].start_solutions += stored;
+    }
+    start_segments[i].clear();
+    auto start = std::chrono::steady_clock::now();
+    SCIP_CALL(SCIPsolve(scip_pricers[i]));
+    MasterNodeStats& node_stats = stats.master_nodes[i];
+    node_stats.exact_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    ++node_stats.exact_solves;
+    node_stats.cuts_generated = conshdlrs[i]->getCutsGenerated();
+    node_stats.cuts_applied = conshdlrs[i]->getCutsApplied();
+    node_stats.pool_cuts_applied = conshdlrs[i]->getPoolCutsApplied();
+    node_stats.flow_cuts_applied = conshdlrs[i]->getFlowCutsApplied();
+    node_stats.prop_fixings = conshdlrs[i]->getPropFixings();
+    node_stats.enfo_fallbacks = conshdlrs[i]->getEnfoFallbacks();
+    node_stats.sepa_calls = conshdlrs[i]->getSepaCalls();
+
+    r.lower_bound = SCIPgetDualbound(scip_pricers[i]) - lambda;
+
+    // with the cutoff, there is no solution if no segment has negative reduced costs
+    SCIP_SOL* best_sol = SCIPgetBestSol(scip_pricers[i]);
+    if (reuse && best_sol != NULL)
+    {
+        last_segments[i] = segmentFromPricerSCIP(scip_pricers[i], best_sol);
+    }
+
+    // besides the optimal segment, the solution store holds further connected segments, the best one first
+    std::vector<Column> candidates;
+    SCIP_SOL** sols = SCIPgetSols(scip_pricers[i]);
+    int num_sols = max_columns > 1 ? SCIPgetNSols(scip_pricers[i]) : std::min(SCIPgetNSols(scip_pricers[i]), 1);
+    for (int j = 0; j < num_sols; ++j)
+    {
+        //TODO compare SolOrigObj to sum -mu_s + |y_t - y_s|
+        SCIP_Real redcost = SCIPgetSolOrigObj(scip_pricers[i], sols[j]) - lambda;
+        if (SCIPisDualfeasNegative(scip, redcost))
+        {
+            candidates.push_back(Column{redcost, segmentFromPricerSCIP(scip_pricers[i], sols[j]), 0.0});
+        }
+    }
+    selectColumns(candidates, r.columns);
+    return SCIP_OKAY;
+}
+
+void SegmentPricer::selectColumns(std::vector<Column>& candidates, std::vector<Column>& columns) const
+{
+    std::stable_sort(candidates.begin(), candidates.end(), [](const Column& a, const Column& b) {
+        return a.redcost < b.redcost;
+    });
+    for (auto& candidate : candidates)
+    {
+        if (columns.size() >= static_cast<size_t>(max_columns))
+        {
+            break;
+        }
+        std::sort(candidate.superpixels.begin(), candidate.superpixels.end());
+        bool diverse = true;
+        for (auto& column : columns)
+        {
+            // number of superpixels contained in exactly one of both segments
+            std::vector<Graph::vertex_descriptor> difference;
+            std::set_symmetric_difference(column.superpixels.begin(), column.superpixels.end(),
+                candidate.superpixels.begin(), candidate.superpixels.end(), std::back_inserter(difference));
+            size_t larger = std::max(column.superpixels.size(), candidate.superpixels.size());
+            if (difference.empty() || difference.size() < diversity * larger)
+            {
+                diverse = false;
+                break;
+            }
+        }
+        if (diverse)
+        {
+            columns.push_back(std::move(candidate));
+        }
+    }
+}
+
+std::pair<SCIP_Real, std::vector<Graph::vertex_descriptor>> SegmentPricer::heuristic(
+    SCIP* scip,
+    Graph::vertex_descriptor master_node,
+    SCIP_Real lambda,
+    std::vector<std::pair<SCIP_Real, size_t>>* prefixes
+    )
+{
+    typedef std::pair<SCIP_Real, Graph::vertex_descriptor> Candidate; // pair<cost, superpixel>
+
+    size_t i = master_index[master_node];
+    // superpixels that are in the segment or in the frontier, or may not be added at all
+    dynamic_bitset<> visited(excluded[i]);
+    // superpixels adjacent to the segment, the cheapest one (with the smallest index on ties) on top
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> frontier;
+
+    std::vector<Graph::vertex_descriptor> superpixels;
+    SCIP_Real redcost = -mu[master_node] - lambda;
+    Graph::vertex_descriptor added = master_node;
+    superpixels.push_back(master_node);
+    size_t missing = required[i].count() - 1; // number of required superpixels not yet in the segment
+    if (prefixes != NULL && missing == 0 && SCIPisDualfeasNegative(scip, redcost))
+    {
+        prefixes->push_back(std::pair<SCIP_Real, size_t>(redcost, 1));
+    }
+    while (true)
+    {
+        // only the neighbours of the superpixel added last can be new in the frontier
+        for (const uint32_t* target = g.neighboursBegin(added); target != g.neighboursEnd(added); ++target)
+        {
+            if (!visited[*target])
+            {
+                visited.set(*target);
+                frontier.push(Candidate(-mu[*target] + cost_scale * std::abs(g.color(master_node) - g.color(*target)), *target));
+            }
+        }
+        if (frontier.empty())
+        {
+            if (missing > 0)
+            {
+                redcost = SCIPinfinity(scip);
+            }
+            break;
+        }
+        Candidate minimum = frontier.top();
+        if (SCIPisNegative(scip, minimum.first)
+            || !SCIPisDualfeasNegative(scip, redcost) || missing > 0)
+        {
+            frontier.pop();
+            added = minimum.second;
+            superpixels.push_back(added);
+            redcost += minimum.first;
+            missing -= required[i][added];
+            if (prefixes != NULL && missing == 0 && SCIPisDualfeasNegative(scip, redcost))
+            {
+                prefixes->push_back(std::pair<SCIP_Real, size_t>(redcost, superpixels.size()));
+            }
         }
         else
         {
@@ -165,40 +802,79 @@ std::pair<SCIP_Real, std::vector<Graph::vertex_descriptor>> SegmentPricer::heuri
     return std::pair<SCIP_Real, std::vector<Graph::vertex_descriptor>>(redcost, superpixels);
 }
 
-SCIP_RETCODE SegmentPricer::addPartitionVarFromPricerSCIP(SCIP* scip, SCIP* scip_pricer, SCIP_SOL* sol, Graph::vertex_descriptor t)
+std::vector<Graph::vertex_descriptor> SegmentPricer::segmentFromPricerSCIP(SCIP* scip_pricer, SCIP_SOL* sol)
 {
     auto probdata = (PricerData*) SCIPgetObjProbData(scip_pricer);
-    SCIP_Real lambda = SCIPgetDualsolLinear(scip, num_segments_cons);
 
     std::vector<Graph::vertex_descriptor> superpixels;
-    for (auto s = vertices(g); s.first != s.second; ++s.first)
+    for (size_t s = 0; s < g.numVertices(); ++s)
     {
-        if (SCIPisEQ(scip_pricer, SCIPgetSolVal(scip_pricer, sol, probdata->x[*s.first]), 1.0))
+        if (SCIPisEQ(scip_pricer, SCIPgetSolVal(scip_pricer, sol, probdata->x[s]), 1.0))
         {
-            superpixels.push_back(*s.first);
+            superpixels.push_back(s);
         }
     }
-    std::cout << "pricer successful: " << superpixels.size() << std::endl;
-    std::cout << "reduced costs: " <<  SCIPgetSolOrigObj(scip_pricer, sol) - lambda << std::endl;
-    SCIP_CALL(addPartitionVar(scip, t, superpixels));
+    return superpixels;
+}
+
+SCIP_RETCODE SegmentPricer::addInitialSegment(SCIP* scip, Graph::vertex_descriptor master_node, const std::vector<Graph::vertex_descriptor>& superpixels)
+{
+    std::vector<uint32_t> sorted(superpixels.begin(), superpixels.end());
+    std::sort(sorted.begin(), sorted.end());
+    SCIP_Real error_P = 0.0;
+    for (auto s : sorted)
+    {
+        error_P += std::abs(g.color(master_node) - g.color(s));
+    }
+    size_t column = column_pool->add(master_node, sorted, error_P);
+    if (column == ColumnPool::NOT_FOUND)
+    {
+        return SCIP_OKAY;
+    }
+
+    auto vardata = new ObjVardataSegment(*column_pool, column);
+    SCIP_VAR* x_P;
+    SCIP_CALL(SCIPcreateObjVar(scip, & x_P, "x_P", 0.0, 1.0, error_P, SCIP_VARTYPE_BINARY, TRUE, FALSE, vardata, TRUE));
+    SCIP_CALL(SCIPaddVar(scip, x_P));
+    for (auto s : sorted)
+    {
+        SCIP_CALL(SCIPaddCoefLinear(scip, partitioning_cons[s], x_P, 1.0));
+    }
+    SCIP_CALL(SCIPaddCoefLinear(scip, num_segments_cons, x_P, 1.0));
+    column_vars.push_back(x_P);
+
+    SCIP_CALL(SCIPreleaseVar(scip, &x_P));
+
     return SCIP_OKAY;
 }
 
-SCIP_RETCODE SegmentPricer::addPartitionVar(SCIP* scip, Graph::vertex_descriptor master_node, std::vector<Graph::vertex_descriptor> superpixels)
+SCIP_RETCODE SegmentPricer::addPartitionVar(SCIP* scip, Graph::vertex_descriptor master_node, const std::vector<Graph::vertex_descriptor>& superpixels, bool* added)
 {
+    std::vector<uint32_t> sorted(superpixels.begin(), superpixels.end());
+    std::sort(sorted.begin(), sorted.end());
     SCIP_Real error_P = 0.0;
-    for (auto s : superpixels)
+    for (auto s : sorted)
+    {
+        error_P += std::abs(g.color(master_node) - g.color(s));
+    }
+
+    size_t column = column_pool->add(master_node, sorted, error_P);
+    *added = column != ColumnPool::NOT_FOUND;
+    if (!*added)
     {
-        error_P += std::abs(g[master_node].color - g[s].color);
+        // the segment has been priced before, its variable is already in the problem
+        // and SCIP returns it to the LP if it has negative reduced costs
+        return SCIP_OKAY;
     }
 
-    auto vardata = new ObjVardataSegment(superpixels);
+    auto vardata = new ObjVardataSegment(*column_pool, column);
     SCIP_VAR* x_P;
     SCIP_CALL(SCIPcreateObjVar(scip, & x_P, "x_P", 0.0, 1.0, error_P, SCIP_VARTYPE_BINARY, FALSE, FALSE, vardata, TRUE));
+    column_vars.push_back(x_P);
     SCIP_CALL(SCIPaddPricedVar(scip, x_P, 1.0));
 
     // add coefficients to constraints (of the master problem)
-    for (auto s : superpixels)
+    for (auto s : sorted)
     {
         SCIP_CALL(SCIPaddCoefLinear(scip, partitioning_cons[s], x_P, 1.0));
     }
@@ -208,3 +884,46 @@ SCIP_RETCODE SegmentPricer::addPartitionVar(SCIP* scip, Graph::vertex_descriptor
 
     return SCIP_OKAY;
 }
+
+SCIP_RETCODE SegmentPricer::findOrAddSegment(SCIP* scip, Graph::vertex_descriptor master_node, const std::vector<Graph::vertex_descriptor>& superpixels, SCIP_VAR** var)
+{
+    std::vector<uint32_t> sorted(superpixels.begin(), superpixels.end());
+    std::sort(sorted.begin(), sorted.end());
+    size_t column = column_pool->find(sorted);
+    if (column != ColumnPool::NOT_FOUND)
+    {
+        *var = column_vars[column];
+        return SCIP_OKAY;
+    }
+
+    SCIP_Real error_P = 0.0;
+    for (auto s : sorted)
+    {
+        error_P += std::abs(g.color(master_node) - g.color(s));
+    }
+    column = column_pool->add(master_node, sorted, error_P);
+    auto vardata = new ObjVardataSegment(*column_pool, column);
+    SCIP_VAR* x_P;
+    SCIP_CALL(SCIPcreateObjVar(scip, & x_P, "x_P", 0.0, 1.0, error_P, SCIP_VARTYPE_BINARY, FALSE, FALSE, vardata, TRUE));
+    SCIP_CALL(SCIPaddVar(scip, x_P));
+    for (auto s : sorted)
+    {
+        SCIP_CALL(SCIPaddCoefLinear(scip, partitioning_cons[s], x_P, 1.0));
+    }
+    SCIP_CALL(SCIPaddCoefLinear(scip, num_segments_cons, x_P, 1.0));
+    column_vars.push_back(x_P);
+    *var = x_P;
+
+    // the assignment constraints only fix the variables that existed when the node was propagated,
+    // SCIP would otherwise return a segment violating the branching decisions to the node LP
+    updateDomains();
+    if (!respectsDomain(master_index[master_node], sorted.begin(), sorted.end()))
+    {
+        SCIP_CALL(SCIPchgVarUbNode(scip, NULL, x_P, 0.0));
+    }
+
+    // the problem holds a reference to the variable
+    SCIP_CALL(SCIPreleaseVar(scip, &x_P));
+
+    return SCIP_OKAY;
+}
@@ -1,5 +1,19 @@
+#ifndef PRICER_H
+#define PRICER_H
+
 #include <objscip/objscip.h>
+#include <boost/dynamic_bitset.hpp>
+#include <memory>
 #include "graph.h"
+#include "csr_graph.h"
+#include "threadpool.h"
+#include "stats.h"
+#include "column_pool.h"
+#include "connected_subgraph_solver.h"
+#include "cut_pool.h"
+
+class ConnectivityCons;
+class AssignmentCons;
 
 using namespace scip;
 
@@ -16,10 +30,11 @@ public:
      */
     SegmentPricer(
         SCIP* scip, ///< master SCIP instance
-        Graph& g_, ///< the graph of superpixels
+        const CsrGraph& g_, ///< the graph of superpixels
         std::vector<Graph::vertex_descriptor> master_nodes, ///< master nodes of all segments 
         std::vector<SCIP_CONS*> partitioning_cons, 
-        SCIP_CONS* num_segments_cons
+        SCIP_CONS* num_segments_cons,
+        RunStats& stats ///< pricing rounds, per master node statistics and the LP bound of each round are recorded in here
         );
 
     /**
@@ -39,38 +54,331 @@ public:
      * If the reduced costs are negative, i.e. 
      * \f[-\sum_{s\in\mathcal{S}} x_s\cdot\mu_s + \sum_{s\in\mathcal{S}} x_s\cdot|y_t-y_s| < \lambda,\f]
      * the generated segment consisting of all superpixels \f$s\f$ for which \f$x_s = 1\f$ is added to the master problem.
-     * @todo add a heuristic
+     *
+     * The pricing problems are independent of each other. If the parameter `pricers/fitting_pricer/threads`
+     * is larger than 1, they are solved concurrently. The resulting columns are added afterwards
+     * in the order of the master nodes, so that the set of columns does not depend on the number of threads.
+     *
+     * If the parameter `pricers/fitting_pricer/smoothing` \f$\alpha\f$ is positive, the duals are stabilized
+     * by Wentges smoothing: the pricing problems are solved for the dual point
+     * \f$\alpha\bar\pi + (1-\alpha)\pi\f$, where \f$\pi\f$ are the duals of the master LP and the stability center
+     * \f$\bar\pi\f$ is the dual point with the best Lagrangian bound at the current node so far. Only segments with negative reduced costs
+     * with respect to \f$\pi\f$ are added. If there is none (a mispricing), the pricing problems are solved again for \f$\pi\f$,
+     * so that the column generation only stops if no segment has negative reduced costs for the master LP.
+     *
+     * If all pricing problems were solved exactly for the duals \f$(\mu, \lambda)\f$, smoothed or not, no segment of the master
+     * node \f$t\f$ has reduced costs below the dual bound \f$\underline{r}_t\f$ of its pricing problem. Since every segmentation
+     * contains one segment of each master node, \f$\sum_{s\in\mathcal{S}}\mu_s + |T|\lambda + \sum_{t\in T}\min(0, \underline{r}_t)\f$
+     * is a lower bound (the Lagrangian bound). The best one of the round is passed to SCIP.
+     * If its relative gap to the LP value \f$z_{LP}\f$ is at most `pricers/fitting_pricer/gaptol`, the pricing is stopped early.
+     *
+     * If the parameter `pricers/fitting_pricer/poolpricing` is set, the segments of the column pool are priced first
+     * (see `pricePool`). The pricing problems of master nodes with an improving segment in the pool are not solved in this round,
+     * SCIP adds the variables of these segments to the LP by its pricing of problem variables.
+     *
+     * The branching decisions of the current node are respected by all pricing methods, see `updateDomains`.
      */
     virtual SCIP_DECL_PRICERREDCOST(scip_redcost);
-    
+
+    /**
+     * Farkas pricing method of variable pricer for infeasible LPs
+     * Below the root, the artificial initial segments are fixed to 0, so the master LP of a node may be infeasible.
+     * The pricing problems are then solved for the dual Farkas values \f$\mu_s\f$ and \f$\lambda\f$ of the master LP
+     * and segment costs 0, i.e. a segment is added if \f$-\sum_{s\in P}\mu_s < \lambda\f$.
+     * If no such segment respects the branching decisions, the node is infeasible and SCIP cuts it off.
+     */
+    virtual SCIP_DECL_PRICERFARKAS(scip_farvar);
+
+    /**
+     * Solves the pricing problems of all master nodes for the dual values in `mu` and `lambda`
+     * The connectivity cuts found are collected by the connectivity constraint handlers until `endCutRound`.
+     */
+    SCIP_RETCODE solvePricingProblems(
+        SCIP* scip, ///< master SCIP instance
+        SCIP_Real lambda ///< dual value of the constraint on the number of segments
+        );
+
+    /**
+     * Merges the connectivity cuts found since the last pricing round into the cut pool
+     * Called once per call of `scip_redcost`, so that cuts age by pricing rounds.
+     */
+    void endCutRound();
+
+    /**
+     * @return the Lagrangian bound for the dual values in `mu` and `lambda` from the results of the last
+     * `solvePricingProblems`, -infinity if not all pricing problems were solved exactly
+     */
+    SCIP_Real lagrangianBound(
+        SCIP* scip, ///< master SCIP instance
+        SCIP_Real lambda ///< dual value of the constraint on the number of segments
+        ) const;
+
+    /**
+     * Moves the stability center of the smoothing to the dual values in `mu` and `lambda` if their Lagrangian bound
+     * is better than the one of the center at the current node
+     */
+    void updateCenter(
+        SCIP* scip, ///< master SCIP instance
+        SCIP_Real lambda, ///< dual value of the constraint on the number of segments
+        SCIP_Real bound ///< Lagrangian bound at the dual values, see `lagrangianBound`
+        );
+
+    /**
+     * Solves the pricing problem for the master node `master_nodes[i]`
+     * The greedy heuristic is tried first, the pricing problem is solved exactly only if the heuristic fails.
+     * If `pricers/fitting_pricer/engine` is 1, the combinatorial branch-and-bound is used for this, and the pricing SCIP
+     * `scip_pricers[i]` only if it reaches its node limit. If `pricers/fitting_pricer/validate` is set, the pricing SCIP
+     * is solved as well and a different optimal value is reported.
+     * This method only reads the dual values stored by `scip_redcost` and only modifies the data of master node `i`,
+     * so it may be called for different master nodes at the same time.
+     *
+     * Up to `pricers/fitting_pricer/maxcolumns` segments are returned. If the heuristic succeeds,
+     * the candidates are the prefixes of its segment with negative reduced costs,
+     * otherwise the segments with negative reduced costs found by the exact method, see `selectColumns`.
+     */
+    SCIP_RETCODE solvePricingProblem(
+        SCIP* scip, ///< master SCIP instance
+        size_t i, ///< index of the master node
+        SCIP_Real lambda ///< dual value of the constraint on the number of segments
+        );
+
+    /**
+     * Solves the pricing SCIP `scip_pricers[i]` of the master node `master_nodes[i]` without trying the heuristic first
+     * The result is stored in `pricing_results[i]`.
+     * The problem of the pricing SCIP is created once, but transformed anew in every call with the new objective function,
+     * so that the connectivity cuts of earlier rounds are only available through the shared CutPool.
+     * The segment of the failed greedy heuristic (only without the cutoff), the best segment of the combinatorial branch-and-bound if it reached
+     * its node limit and, if the parameter `pricers/fitting_pricer/reuse` is set, the optimal segment of the previous call
+     * are passed as start solutions.
+     * If the parameter `pricers/fitting_pricer/cutoff` is set, the objective limit of the pricing SCIP is \f$\lambda\f$,
+     * so that it stops as soon as it proves that no segment has negative reduced costs. The lower bound is then only
+     * valid if it is negative, which suffices for the Lagrangian bound.
+     */
+    SCIP_RETCODE solveExactly(
+        SCIP* scip, ///< master SCIP instance
+        size_t i, ///< index of the master node
+        SCIP_Real lambda ///< dual value of the constraint on the number of segments
+        );
+
+    /**
+     * Solves the pricing problem of the master node `master_nodes[i]` by the combinatorial branch-and-bound
+     * The result is stored in `pricing_results[i]`. The candidates are the improving segments found during the search.
+     * @return false if the node limit `pricers/fitting_pricer/bbnodes` was reached, then `pricing_results[i]` is not set
+     */
+    bool solveCombinatorially(
+        SCIP* scip, ///< master SCIP instance
+        size_t i, ///< index of the master node
+        SCIP_Real lambda ///< dual value of the constraint on the number of segments
+        );
+
+    /**
+     * Greedy heuristic for the pricing problem of `master_node`
+     * Starting with the master node, the segment is grown by the adjacent superpixel \f$s\f$
+     * with the smallest costs \f$-\mu_s + |y_t-y_s|\f$ as long as these costs are negative,
+     * the reduced costs of the segment are not yet negative or a superpixel required by the branching decisions is missing.
+     * Superpixels excluded by the branching decisions are never added. If a required superpixel cannot be reached,
+     * the reduced costs are infinite.
+     * The adjacent superpixels are kept in a heap, so that growing a segment by \f$m\f$ superpixels
+     * takes \f$O(m\cdot\deg\cdot\log n)\f$ time.
+     * Every prefix of the returned superpixels is a connected segment, too.
+     * @return pair of the reduced costs and the superpixels of the segment, in the order they were added
+     */
     std::pair<SCIP_Real, std::vector<Graph::vertex_descriptor>> heuristic(
         SCIP* scip,
         Graph::vertex_descriptor master_node,
-        SCIP_Real lambda
+        SCIP_Real lambda,
+        std::vector<std::pair<SCIP_Real, size_t>>* prefixes = NULL ///< if not NULL, the reduced costs and lengths of all prefixes with negative reduced costs are stored in here
         );
 
     /**
-     * Calls `addPartitionVar` with the vector of all superpixels \f$s\f$ for which \f$x_s = 1\f$
+     * @return the vector of all superpixels \f$s\f$ for which \f$x_s = 1\f$ in the solution `sol` of the pricing problem
      */
-    SCIP_RETCODE addPartitionVarFromPricerSCIP(SCIP* scip, SCIP* scip_pricer, SCIP_SOL* sol, Graph::vertex_descriptor t);
+    std::vector<Graph::vertex_descriptor> segmentFromPricerSCIP(SCIP* scip_pricer, SCIP_SOL* sol);
     
+    /**
+     * Adds a segment variable to the original master problem before it is solved
+     * Unlike the artificial initial segments, the variable has the actual costs of the segment and variable data,
+     * so it may be part of the final segmentation. The constraints must not be transformed yet.
+     */
+    SCIP_RETCODE addInitialSegment(
+        SCIP* scip, ///< master SCIP instance in the problem stage
+        Graph::vertex_descriptor master_node, ///< the master node of the segment
+        const std::vector<Graph::vertex_descriptor>& superpixels ///< the superpixels of the segment, which must be connected
+        );
+
     /**
      * Adds a new segment variable to the master problem
-     * This also adds the variable to the appropriate existing constraints.
+     * This also adds the variable to the appropriate existing constraints. Segments that are already
+     * contained in the column pool are rejected before a variable is created.
      */
-    SCIP_RETCODE addPartitionVar(SCIP* scip, Graph::vertex_descriptor master_node, std::vector<Graph::vertex_descriptor> superpixels);
+    SCIP_RETCODE addPartitionVar(
+        SCIP* scip,
+        Graph::vertex_descriptor master_node,
+        const std::vector<Graph::vertex_descriptor>& superpixels,
+        bool* added ///< set to false if the segment is a duplicate and no variable was created
+        );
+
+    /**
+     * Finds the variable of a segment, creating it if the segment is not contained in the column pool
+     * Unlike `addPartitionVar`, a new variable is only added to the problem and not to the current LP,
+     * so this may be called outside of the pricing, e.g. by primal heuristics. A new variable violating the branching
+     * decisions of the current node is fixed to 0 at this node.
+     */
+    SCIP_RETCODE findOrAddSegment(
+        SCIP* scip, ///< master SCIP instance in the solving stage
+        Graph::vertex_descriptor master_node, ///< the master node of the segment
+        const std::vector<Graph::vertex_descriptor>& superpixels, ///< the superpixels of the segment, which must be connected
+        SCIP_VAR** var ///< pointer to store the variable of the segment
+        );
+
+    /**
+     * Prices the segments of the column pool for the duals of the master LP
+     * Segments whose variables are not in the current LP (e.g. because they were added in another part
+     * of the branch-and-bound tree, or by a primal heuristic) can have negative reduced costs again.
+     * Segments violating the branching decisions of the current node are skipped. The others with negative
+     * reduced costs are stored in `pricing_results[i].pool_columns` for each master node `master_nodes[i]`.
+     * All segments of the pool are problem variables already, so they are not added again.
+     */
+    void pricePool(SCIP* scip);
+
+    /**
+     * Computes the superpixels required and excluded in the pricing problem of each master node
+     * from the branching decisions active at the current node of the master problem
+     * A segment of the master node \f$t\f$ must contain \f$t\f$ and every superpixel \f$s\f$ with a decision that \f$s\f$
+     * belongs to the segment of \f$t\f$. It must not contain the other master nodes, superpixels with a decision that they do not
+     * belong to the segment of \f$t\f$, or superpixels that belong to the segment of another master node.
+     */
+    void updateDomains();
+
+    /**
+     * @return whether the segment of the superpixels in [`first`, `last`) respects the branching decisions
+     * for the master node `master_nodes[i]`
+     */
+    template <typename Iterator>
+    bool respectsDomain(size_t i, Iterator first, Iterator last) const
+    {
+        size_t contained = 0;
+        for (; first != last; ++first)
+        {
+            if (excluded[i][*first])
+            {
+                return false;
+            }
+            contained += required[i][*first];
+        }
+        return contained == required[i].count();
+    }
+
+    /**
+     * Sets the dual values \f$\mu_s\f$ used by `heuristic` and `solveExactly`
+     * These are normally read from the master LP in `scip_redcost`, this allows to run the pricing
+     * methods on given dual values, e.g. in benchmarks. The pricer must have been initialized.
+     */
+    void setDuals(const std::vector<SCIP_Real>& mu_)
+    {
+        mu = mu_;
+    }
+
+    /**
+     * @return the lower bound on the reduced costs of the segments of the master node `master_nodes[i]` found by the last pricing solve
+     */
+    SCIP_Real getLowerBound(size_t i) const
+    {
+        return pricing_results[i].lower_bound;
+    }
+
+    /**
+     * @return the pricing SCIP instance of the master node `master_nodes[i]`
+     */
+    SCIP* getPricingSCIP(size_t i) const
+    {
+        return scip_pricers[i];
+    }
 
 private:
-    Graph& g;
+    const CsrGraph& g;
     std::vector<Graph::vertex_descriptor> master_nodes;
     std::vector<SCIP_CONS*> partitioning_cons;
     SCIP_CONS* num_segments_cons;
+    RunStats& stats;
 
     // pricing problem data
     std::vector<SCIP*> scip_pricers; // k instances (one for each t in T)
+    std::vector<ConnectivityCons*> conshdlrs; ///< connectivity constraint handler of each pricing SCIP
     int _bigM;
     int _n;
 
+    int threads; ///< number of threads used to solve the pricing problems
+    SCIP_Bool reuse; ///< start from the previous optimal segment in each exact pricing solve
+    SCIP_Bool cutoff; ///< set the objective limit of each exact pricing solve to the reduced cost threshold
+    int cut_pool_size; ///< maximum number of components in the cut pool
+    int cut_pool_age; ///< number of rounds an unused component stays in the cut pool
+    std::unique_ptr<CutPool> cut_pool; ///< connectivity cuts shared by all pricing problems
+    std::unique_ptr<ColumnPool> column_pool; ///< superpixels of all segment variables, referenced by their variable data
+    std::vector<SCIP_VAR*> column_vars; ///< segment variable of each column of the column pool, the transformed one once `scip_init` was called
+    std::vector<SCIP_Real> pool_redcosts; ///< reduced costs of the columns of the column pool in the current round
+    std::vector<size_t> master_index; ///< `master_index[t]` is the index of the master node `t` in `master_nodes`
+    SCIP_Bool pool_pricing; ///< price the column pool before solving the pricing problems
+    int engine; ///< method of solving the pricing problems exactly, 0: pricing SCIP, 1: combinatorial branch-and-bound
+    int bb_node_limit; ///< node limit of the combinatorial branch-and-bound
+    SCIP_Bool validate; ///< compare the optimal values of the combinatorial branch-and-bound to the pricing SCIP
+    std::vector<std::unique_ptr<ConnectedSubgraphSolver>> subgraph_solvers; ///< combinatorial solver of each pricing problem
+    std::vector<std::vector<Graph::vertex_descriptor>> last_segments; ///< optimal segment of the last exact solve of each pricing problem
+    std::vector<std::vector<std::vector<Graph::vertex_descriptor>>> start_segments; ///< segments of the heuristics passed to the next exact solve of each pricing problem
+    std::unique_ptr<ThreadPool> pool;
+    dynamic_bitset<> master_mask; ///< `master_mask[s]` is set iff \f$s\in T\f$
+    std::vector<SCIP_Real> mu; ///< dual values \f$\mu_s\f$ the pricing problems are solved for, indexed by superpixel
+    std::vector<SCIP_Real> lp_mu; ///< dual values \f$\mu_s\f$ of the current master LP
+    SCIP_Real smoothing; ///< Wentges smoothing factor \f$\alpha\f$, 0 disables the stabilization
+    std::vector<SCIP_Real> center_mu; ///< dual values \f$\mu_s\f$ of the stability center, empty before the first round
+    SCIP_Real center_lambda; ///< dual value \f$\lambda\f$ of the stability center
+    SCIP_Real center_bound; ///< Lagrangian bound at the stability center, -infinity if unknown
+    SCIP_Longint center_node; ///< number of the node of the master problem the center bound belongs to
+    SCIP_Real gap_tolerance; ///< relative gap between the LP value and the Lagrangian bound at which the pricing stops
+    SCIP_Real cost_scale; ///< factor of the segment costs \f$|y_t-y_s|\f$ in the pricing problems, 0 in Farkas pricing
+    AssignmentCons* assignment_cons; ///< constraint handler of the branching decisions, NULL if branching is not enabled
+    std::vector<dynamic_bitset<>> required; ///< `required[i][s]` is set iff the segments of `master_nodes[i]` must contain `s`
+    std::vector<dynamic_bitset<>> excluded; ///< `excluded[i][s]` is set iff the segments of `master_nodes[i]` must not contain `s`
+    std::vector<bool> feasible_domains; ///< whether the decisions of `master_nodes[i]` allow any segment
+
+    /**
+     * Segment with negative reduced costs found by a pricing problem
+     */
+    struct Column
+    {
+        SCIP_Real redcost; ///< reduced costs of the segment for the duals the pricing problem was solved for
+        std::vector<Graph::vertex_descriptor> superpixels; ///< superpixels contained in the segment
+        SCIP_Real lp_redcost; ///< reduced costs of the segment for the duals of the master LP, set by `scip_redcost`
+    };
+
+    /**
+     * Outcome of solving the pricing problem of a single master node
+     */
+    struct PricingResult
+    {
+        SCIP_RETCODE retcode; ///< return code of the pricing run
+        bool by_heuristic; ///< whether the segments were found by the heuristic
+        SCIP_Real lower_bound; ///< lower bound on the reduced costs of all segments of the master node, -infinity if unknown
+        std::vector<Column> columns; ///< the segments with negative reduced costs, the best one first
+        std::vector<size_t> pool_columns; ///< columns of the column pool with negative reduced costs outside the LP, if not empty the pricing problem is not solved
+    };
+    std::vector<PricingResult> pricing_results; ///< `pricing_results[i]` belongs to `master_nodes[i]`
+
+    int max_columns; ///< maximum number of segments per master node and pricing round
+    SCIP_Real diversity; ///< minimum fraction of superpixels in which two segments added for the same master node differ
+
+    /**
+     * Selects the segments to add from the candidates of one pricing problem
+     * The candidates are taken in the order of increasing reduced costs. A candidate is skipped if its symmetric
+     * difference with a segment already selected contains fewer than `diversity` times the size of the larger one
+     * (and always if both are equal), until `max_columns` segments are selected.
+     * The superpixels of the selected segments are sorted.
+     */
+    void selectColumns(
+        std::vector<Column>& candidates, ///< segments with negative reduced costs, they are moved from
+        std::vector<Column>& columns ///< the selected segments are appended to this
+        ) const;
+
     /** 
      * Problem data class for the pricing problem
      */
@@ -83,3 +391,5 @@ private:
         std::vector<SCIP_VAR*> x; ///< variables \f$x_s\f$ for each superpixel \f$s\in\mathcal{S}\f$
     };
 };
+
+#endif
@@ -0,0 +1,90 @@
+#include <algorithm>
+#include "rounding_heur.h"
+#include "master.h"
+#include "pricer.h"
+#include "vardata.h"
+
+RoundingHeur::RoundingHeur(SCIP* scip, const CsrGraph& g_, const std::vector<Graph::vertex_descriptor>& master_nodes_, SegmentPricer& pricer_, RunStats& stats_) :
+    ObjHeur(scip, "segmentrounding", "rounds the segments of the LP solution and assigns the remaining superpixels to adjacent segments",
+        'g', 10000, 1, 0, -1, SCIP_HEURTIMING_AFTERLPNODE | SCIP_HEURTIMING_DURINGPRICINGLOOP, FALSE),
+    g(g_), master_nodes(master_nodes_), master_index(g_.numVertices(), 0), pricer(pricer_), stats(stats_)
+{
+    for (size_t i = 0; i < master_nodes.size(); ++i)
+    {
+        master_index[master_nodes[i]] = i;
+    }
+}
+
+SCIP_DECL_HEUREXEC(RoundingHeur::scip_exec)
+{
+    *result = SCIP_DIDNOTRUN;
+    if (!SCIPhasCurrentNodeLP(scip) || SCIPgetLPSolstat(scip) != SCIP_LPSOLSTAT_OPTIMAL)
+    {
+        return SCIP_OKAY;
+    }
+    *result = SCIP_DIDNOTFIND;
+    ++stats.rounding_calls;
+
+    // the segments used by the LP solution, the largest value first
+    typedef std::pair<SCIP_Real, ObjVardataSegment*> Candidate; // pair<LP value, variable data>
+    std::vector<Candidate> candidates;
+    SCIP_VAR** vars = SCIPgetVars(scip);
+    for (int j = 0; j < SCIPgetNVars(scip); ++j)
+    {
+        SCIP_Real value = SCIPgetSolVal(scip, NULL, vars[j]);
+        auto vardata = getSegmentVardata(scip, vars[j]);
+        if (vardata != NULL && SCIPisFeasPositive(scip, value))
+        {
+            candidates.push_back(Candidate(value, vardata));
+        }
+    }
+    std::stable_sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        return a.first > b.first;
+    });
+
+    std::vector<std::vector<Graph::vertex_descriptor>> segments(master_nodes.size());
+    std::vector<bool> covered(g.numVertices(), false);
+    for (auto& candidate : candidates)
+    {
+        ObjVardataSegment* vardata = candidate.second;
+        size_t i = master_index[vardata->getMasterNode()];
+        if (!segments[i].empty()
+            || std::any_of(vardata->begin(), vardata->end(), [&covered](uint32_t s) { return covered[s]; }))
+        {
+            continue;
+        }
+        for (const uint32_t* s = vardata->begin(); s != vardata->end(); ++s)
+        {
+            covered[*s] = true;
+            segments[i].push_back(*s);
+        }
+    }
+    for (size_t i = 0; i < master_nodes.size(); ++i)
+    {
+        if (segments[i].empty())
+        {
+            segments[i].push_back(master_nodes[i]);
+        }
+    }
+    if (!completeSegments(g, master_nodes, segments))
+    {
+        return SCIP_OKAY;
+    }
+
+    SCIP_SOL* sol;
+    SCIP_CALL(SCIPcreateSol(scip, &sol, heur));
+    for (size_t i = 0; i < master_nodes.size(); ++i)
+    {
+        SCIP_VAR* var;
+        SCIP_CALL(pricer.findOrAddSegment(scip, master_nodes[i], segments[i], &var));
+        SCIP_CALL(SCIPsetSolVal(scip, sol, var, 1.0));
+    }
+    SCIP_Bool stored;
+    SCIP_CALL(SCIPtrySolFree(scip, &sol, FALSE, FALSE, TRUE, TRUE, TRUE, &stored));
+    if (stored)
+    {
+        ++stats.rounding_solutions;
+        *result = SCIP_FOUNDSOL;
+    }
+    return SCIP_OKAY;
+}
@@ -0,0 +1,51 @@
+#ifndef ROUNDING_HEUR_H
+#define ROUNDING_HEUR_H
+
+#include <objscip/objscip.h>
+#include <vector>
+#include "graph.h"
+#include "csr_graph.h"
+#include "stats.h"
+
+class SegmentPricer;
+
+using namespace scip;
+
+/**
+ * Primal heuristic of the master problem that rounds and repairs the LP solution
+ * The segments of the current LP solution are taken in the order of decreasing values. A segment is selected
+ * if no segment of its master node has been selected yet and it is disjoint from all selected segments.
+ * Master nodes without a selected segment start with a segment containing only themselves.
+ * The superpixels not covered by the selected segments are then assigned by `completeSegments`,
+ * which adds each of them to an adjacent segment, so all segments stay connected.
+ * The resulting segmentation is submitted to SCIP. Segments that are not yet variables of the master problem
+ * are added by the pricer.
+ *
+ * The heuristic is called after the LP of each node and in every round of the pricing loop,
+ * so that good incumbents are available long before the column generation at the root has finished.
+ */
+class RoundingHeur : public ObjHeur
+{
+public:
+    RoundingHeur(
+        SCIP* scip, ///< master SCIP instance
+        const CsrGraph& g, ///< the graph of superpixels
+        const std::vector<Graph::vertex_descriptor>& master_nodes, ///< master nodes of all segments
+        SegmentPricer& pricer, ///< the pricer of the master problem, which owns the column pool
+        RunStats& stats ///< the calls and the solutions found are recorded in here
+        );
+
+    /**
+     * Execution method of primal heuristic
+     */
+    virtual SCIP_DECL_HEUREXEC(scip_exec);
+
+private:
+    const CsrGraph& g;
+    std::vector<Graph::vertex_descriptor> master_nodes;
+    std::vector<size_t> master_index; ///< `master_index[t]` is the index of the master node `t` in `master_nodes`
+    SegmentPricer& pricer;
+    RunStats& stats;
+};
+
+#endif
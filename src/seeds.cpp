@@ -0,0 +1,136 @@
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include "seeds.h"
+
+namespace
+{
+    /**
+     * Splits `list` at every occurrence of `separator`
+     */
+    std::vector<std::string> split(const std::string& list, char separator)
+    {
+        std::vector<std::string> parts;
+        std::stringstream stream(list);
+        std::string part;
+        while (std::getline(stream, part, separator))
+        {
+            parts.push_back(part);
+        }
+        return parts;
+    }
+
+    /**
+     * Parses a non-negative integer with at most 9 digits that makes up the whole string `s`
+     */
+    bool parseNumber(const std::string& s, uint64_t& value)
+    {
+        if (s.empty() || s.size() > 9 || s.find_first_not_of("0123456789") != std::string::npos)
+        {
+            return false;
+        }
+        value = std::stoull(s);
+        return true;
+    }
+
+    void addMasterNode(Graph::vertex_descriptor superpixel, std::vector<Graph::vertex_descriptor>& master_nodes)
+    {
+        if (std::find(master_nodes.begin(), master_nodes.end(), superpixel) == master_nodes.end())
+        {
+            master_nodes.push_back(superpixel);
+        }
+    }
+}
+
+bool readSeedsFile(const std::string& filename, Seeds& seeds)
+{
+    std::ifstream file(filename);
+    if (!file)
+    {
+        std::cerr << "Cannot read seeds file " << filename << std::endl;
+        return false;
+    }
+    std::string line;
+    size_t number = 0;
+    while (std::getline(file, line))
+    {
+        ++number;
+        std::stringstream stream(line);
+        std::string first, second, rest;
+        if (!(stream >> first) || first[0] == '#')
+        {
+            continue;
+        }
+        uint64_t x, y;
+        bool valid = static_cast<bool>(stream >> second) && !(stream >> rest);
+        if (valid && first == "s" && parseNumber(second, x))
+        {
+            seeds.superpixels.push_back(x);
+        }
+        else if (valid && parseNumber(first, x) && parseNumber(second, y))
+        {
+            seeds.pixels.push_back(std::pair<uint32_t, uint32_t>(x, y));
+        }
+        else
+        {
+            std::cerr << filename << ":" << number << ": expected \"x y\" or \"s id\"" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool parsePixelList(const std::string& list, Seeds& seeds)
+{
+    for (auto& pixel : split(list, ';'))
+    {
+        auto xy = split(pixel, ',');
+        uint64_t x, y;
+        if (xy.size() != 2 || !parseNumber(xy[0], x) || !parseNumber(xy[1], y))
+        {
+            std::cerr << "Invalid pixel \"" << pixel << "\", expected x,y" << std::endl;
+            return false;
+        }
+        seeds.pixels.push_back(std::pair<uint32_t, uint32_t>(x, y));
+    }
+    return true;
+}
+
+bool parseSuperpixelList(const std::string& list, Seeds& seeds)
+{
+    for (auto& id : split(list, ','))
+    {
+        uint64_t superpixel;
+        if (!parseNumber(id, superpixel))
+        {
+            std::cerr << "Invalid superpixel id \"" << id << "\"" << std::endl;
+            return false;
+        }
+        seeds.superpixels.push_back(superpixel);
+    }
+    return true;
+}
+
+bool masterNodesFromSeeds(const Seeds& seeds, Image& image, std::vector<Graph::vertex_descriptor>& master_nodes)
+{
+    for (auto xy : seeds.pixels)
+    {
+        if (xy.first >= image.getWidth() || xy.second >= image.getHeight())
+        {
+            std::cerr << "Pixel (" << xy.first << ", " << xy.second << ") is outside of the image" << std::endl;
+            return false;
+        }
+        addMasterNode(image.pixelToSuperpixel(xy.first, xy.second), master_nodes);
+    }
+    for (auto superpixel : seeds.superpixels)
+    {
+        if (superpixel >= image.getSuperpixelCount())
+        {
+            std::cerr << "There is no superpixel " << superpixel << std::endl;
+            return false;
+        }
+        addMasterNode(superpixel, master_nodes);
+    }
+    return true;
+}
@@ -0,0 +1,59 @@
+#ifndef SEEDS_H
+#define SEEDS_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "graph.h"
+#include "image.h"
+
+/**
+ * Master nodes given without user interaction, either as pixel coordinates or as superpixel ids
+ */
+struct Seeds
+{
+    std::vector<std::pair<uint32_t, uint32_t>> pixels; ///< pixel coordinates (x, y), each selects the superpixel containing it
+    std::vector<Graph::vertex_descriptor> superpixels; ///< superpixel ids
+
+    bool empty() const
+    {
+        return pixels.empty() && superpixels.empty();
+    }
+};
+
+/**
+ * Reads seeds from a file
+ * Every non-empty line not starting with `#` is either `x y` for a pixel
+ * or `s id` for a superpixel.
+ * @return false if the file cannot be read or contains an invalid line
+ */
+bool readSeedsFile(
+    const std::string& filename, ///< seeds file
+    Seeds& seeds ///< the seeds are appended to this
+    );
+
+/**
+ * Parses a list of pixel coordinates of the form `x,y;x,y;...`
+ * @return false if the list is malformed
+ */
+bool parsePixelList(const std::string& list, Seeds& seeds);
+
+/**
+ * Parses a list of superpixel ids of the form `id,id,...`
+ * @return false if the list is malformed
+ */
+bool parseSuperpixelList(const std::string& list, Seeds& seeds);
+
+/**
+ * Maps the seeds to master nodes, removing duplicates while keeping the order of first occurrence
+ * Pixels are mapped first, followed by the superpixel ids.
+ * @return false if a pixel lies outside the image or a superpixel id does not exist
+ */
+bool masterNodesFromSeeds(
+    const Seeds& seeds,
+    Image& image,
+    std::vector<Graph::vertex_descriptor>& master_nodes ///< the master nodes are appended to this
+    );
+
+#endif
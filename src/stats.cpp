@@ -0,0 +1,165 @@
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include "stats.h"
+
+namespace
+{
+    /**
+     * Writes `value` as a JSON number, or `null` if it is not finite
+     */
+    void writeNumber(std::ostream& out, double value)
+    {
+        if (std::isfinite(value))
+        {
+            out << value;
+        }
+        else
+        {
+            out << "null";
+        }
+    }
+
+    /**
+     * Writes `value` as a JSON string
+     */
+    void writeString(std::ostream& out, const std::string& value)
+    {
+        out << '"';
+        for (char c : value)
+        {
+            if (c == '"' || c == '\\')
+            {
+                out << '\\';
+            }
+            out << c;
+        }
+        out << '"';
+    }
+}
+
+void RunStats::writeJson(std::ostream& out) const
+{
+    size_t heuristic_hits = 0;
+    size_t heuristic_misses = 0;
+    size_t exact_solves = 0;
+    size_t start_solutions = 0;
+    size_t combinatorial_solves = 0;
+    size_t combinatorial_fallbacks = 0;
+    size_t validation_mismatches = 0;
+    size_t cuts_generated = 0;
+    size_t cuts_applied = 0;
+    size_t pool_cuts_applied = 0;
+    size_t flow_cuts_applied = 0;
+    size_t prop_fixings = 0;
+    size_t enfo_fallbacks = 0;
+    size_t sepa_calls = 0;
+    size_t duplicate_columns = 0;
+    size_t pool_columns = 0;
+    for (auto& node : master_nodes)
+    {
+        pool_cuts_applied += node.pool_cuts_applied;
+        flow_cuts_applied += node.flow_cuts_applied;
+        prop_fixings += node.prop_fixings;
+        enfo_fallbacks += node.enfo_fallbacks;
+        sepa_calls += node.sepa_calls;
+        duplicate_columns += node.duplicate_columns;
+        pool_columns += node.pool_columns;
+        heuristic_hits += node.heuristic_hits;
+        heuristic_misses += node.heuristic_misses;
+        exact_solves += node.exact_solves;
+        start_solutions += node.start_solutions;
+        combinatorial_solves += node.combinatorial_solves;
+        combinatorial_fallbacks += node.combinatorial_fallbacks;
+        validation_mismatches += node.validation_mismatches;
+        cuts_generated += node.cuts_generated;
+        cuts_applied += node.cuts_applied;
+    }
+
+    out << "{" << std::endl;
+    out << "  \"image\": ";
+    writeString(out, image);
+    out << "," << std::endl;
+    out << "  \"superpixels\": " << superpixels << "," << std::endl;
+    out << "  \"phases\": {\"load\": " << phases.load << ", \"slic\": " << phases.slic
+        << ", \"graph\": " << phases.graph << ", \"setup\": " << phases.setup
+        << ", \"solve\": " << phases.solve << ", \"render\": " << phases.render << "}," << std::endl;
+    out << "  \"pricing_rounds\": " << pricing_rounds << "," << std::endl;
+    out << "  \"smoothing\": " << smoothing << "," << std::endl;
+    out << "  \"mispricings\": " << mispricings << "," << std::endl;
+    out << "  \"stopped_early\": " << (stopped_early ? "true" : "false") << "," << std::endl;
+    out << "  \"farkas_rounds\": " << farkas_rounds << "," << std::endl;
+    out << "  \"branchings\": " << branchings << "," << std::endl;
+    out << "  \"assignment_fixings\": " << assignment_fixings << "," << std::endl;
+    out << "  \"rounding_calls\": " << rounding_calls << "," << std::endl;
+    out << "  \"rounding_solutions\": " << rounding_solutions << "," << std::endl;
+    out << "  \"heuristic_hits\": " << heuristic_hits << "," << std::endl;
+    out << "  \"heuristic_misses\": " << heuristic_misses << "," << std::endl;
+    out << "  \"exact_solves\": " << exact_solves << "," << std::endl;
+    out << "  \"start_solutions\": " << start_solutions << "," << std::endl;
+    out << "  \"combinatorial_solves\": " << combinatorial_solves << "," << std::endl;
+    out << "  \"combinatorial_fallbacks\": " << combinatorial_fallbacks << "," << std::endl;
+    out << "  \"validation_mismatches\": " << validation_mismatches << "," << std::endl;
+    out << "  \"cuts_generated\": " << cuts_generated << "," << std::endl;
+    out << "  \"cuts_applied\": " << cuts_applied << "," << std::endl;
+    out << "  \"pool_cuts_applied\": " << pool_cuts_applied << "," << std::endl;
+    out << "  \"flow_cuts_applied\": " << flow_cuts_applied << "," << std::endl;
+    out << "  \"prop_fixings\": " << prop_fixings << "," << std::endl;
+    out << "  \"enfo_fallbacks\": " << enfo_fallbacks << "," << std::endl;
+    out << "  \"sepa_calls\": " << sepa_calls << "," << std::endl;
+    out << "  \"cut_pool_size\": " << cut_pool_size << "," << std::endl;
+    out << "  \"columns\": " << columns << "," << std::endl;
+    out << "  \"duplicate_columns\": " << duplicate_columns << "," << std::endl;
+    out << "  \"pool_columns\": " << pool_columns << "," << std::endl;
+    out << "  \"master_nodes\": [" << std::endl;
+    for (size_t i = 0; i < master_nodes.size(); ++i)
+    {
+        const MasterNodeStats& node = master_nodes[i];
+        out << "    {\"superpixel\": " << node.superpixel
+            << ", \"heuristic_hits\": " << node.heuristic_hits
+            << ", \"heuristic_misses\": " << node.heuristic_misses
+            << ", \"exact_solves\": " << node.exact_solves
+            << ", \"exact_time\": " << node.exact_time
+            << ", \"start_solutions\": " << node.start_solutions
+            << ", \"combinatorial_solves\": " << node.combinatorial_solves
+            << ", \"combinatorial_nodes\": " << node.combinatorial_nodes
+            << ", \"combinatorial_time\": " << node.combinatorial_time
+            << ", \"combinatorial_fallbacks\": " << node.combinatorial_fallbacks
+            << ", \"validation_mismatches\": " << node.validation_mismatches
+            << ", \"cuts_generated\": " << node.cuts_generated
+            << ", \"cuts_applied\": " << node.cuts_applied
+            << ", \"pool_cuts_applied\": " << node.pool_cuts_applied
+            << ", \"flow_cuts_applied\": " << node.flow_cuts_applied
+            << ", \"prop_fixings\": " << node.prop_fixings
+            << ", \"enfo_fallbacks\": " << node.enfo_fallbacks
+            << ", \"sepa_calls\": " << node.sepa_calls
+            << ", \"columns\": " << node.columns
+            << ", \"duplicate_columns\": " << node.duplicate_columns
+            << ", \"pool_columns\": " << node.pool_columns << "}"
+            << (i + 1 < master_nodes.size() ? "," : "") << std::endl;
+    }
+    out << "  ]," << std::endl;
+    out << "  \"lp_bounds\": [" << std::endl;
+    for (size_t i = 0; i < lp_bounds.size(); ++i)
+    {
+        out << "    {\"round\": " << lp_bounds[i].round << ", \"time\": " << lp_bounds[i].time << ", \"value\": ";
+        writeNumber(out, lp_bounds[i].value);
+        out << ", \"lagrangian\": ";
+        writeNumber(out, lp_bounds[i].lagrangian);
+        out << "}" << (i + 1 < lp_bounds.size() ? "," : "") << std::endl;
+    }
+    out << "  ]" << std::endl;
+    out << "}" << std::endl;
+}
+
+bool RunStats::writeJson(const std::string& filename) const
+{
+    std::ofstream file(filename);
+    if (!file)
+    {
+        std::cerr << "Cannot write report " << filename << std::endl;
+        return false;
+    }
+    writeJson(file);
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,99 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <scip/scip.h>
+
+/**
+ * Wall-clock time in seconds spent in each phase of segmenting one image
+ */
+struct PhaseTimes
+{
+    double load = 0.0; ///< reading the PNG image
+    double slic = 0.0; ///< computing the superpixels, their colors and writing the superpixel images
+    double graph = 0.0; ///< building the graph of superpixels
+    double setup = 0.0; ///< creating the master problem and the pricer
+    double solve = 0.0; ///< solving the master problem
+    double render = 0.0; ///< writing the segments
+};
+
+/**
+ * Statistics of the pricing problem of one master node
+ */
+struct MasterNodeStats
+{
+    uint32_t superpixel = 0; ///< the master node
+    size_t heuristic_hits = 0; ///< pricing rounds in which the heuristic found a segment with negative reduced costs
+    size_t heuristic_misses = 0; ///< pricing rounds in which the heuristic failed
+    size_t exact_solves = 0; ///< number of times the pricing SCIP was solved
+    double exact_time = 0.0; ///< wall-clock time in seconds spent in the pricing SCIP
+    size_t start_solutions = 0; ///< segments of the heuristics and previous solves passed to the pricing SCIP
+    size_t combinatorial_solves = 0; ///< pricing problems solved by the combinatorial branch-and-bound
+    size_t combinatorial_nodes = 0; ///< nodes of the combinatorial branch-and-bound, including the runs that hit the node limit
+    double combinatorial_time = 0.0; ///< wall-clock time in seconds spent in the combinatorial branch-and-bound
+    size_t combinatorial_fallbacks = 0; ///< runs of the combinatorial branch-and-bound that hit the node limit
+    size_t validation_mismatches = 0; ///< optimal values of the combinatorial branch-and-bound that differ from the pricing SCIP
+    size_t cuts_generated = 0; ///< connectivity cuts created by the separator of the pricing SCIP
+    size_t cuts_applied = 0; ///< connectivity cuts that were efficacious and added to the LP
+    size_t pool_cuts_applied = 0; ///< connectivity cuts taken from the cut pool and added to the LP, included in `cuts_applied`
+    size_t flow_cuts_applied = 0; ///< connectivity cuts from minimum vertex separators added to the LP, included in `cuts_applied`
+    size_t prop_fixings = 0; ///< variables fixed by the connectivity propagation
+    size_t enfo_fallbacks = 0; ///< enforcement calls that had to leave a disconnected solution to branching
+    size_t sepa_calls = 0; ///< calls of the connectivity separator
+    size_t columns = 0; ///< segment variables added to the master problem
+    size_t duplicate_columns = 0; ///< improving segments that were rejected because they had been added before
+    size_t pool_columns = 0; ///< improving segment variables outside the LP found in the column pool instead of solving the pricing problem
+};
+
+/**
+ * Value of the master LP in one pricing round
+ */
+struct LpBound
+{
+    size_t round; ///< pricing round, starting at 1
+    double time; ///< solving time of the master SCIP in seconds
+    SCIP_Real value; ///< objective value of the master LP
+    SCIP_Real lagrangian; ///< Lagrangian lower bound computed from the pricing problems, NaN if not all were solved exactly
+};
+
+/**
+ * Statistics collected while segmenting one image
+ * The phases are filled in by `segmentImage`, the pricing statistics by `SegmentPricer`.
+ * `master_nodes[i]` is only written by the thread solving the pricing problem of the i-th master node,
+ * so the statistics can be collected while pricing concurrently.
+ */
+struct RunStats
+{
+    std::string image; ///< the input image
+    size_t superpixels = 0; ///< number of superpixels
+    PhaseTimes phases;
+    size_t pricing_rounds = 0; ///< number of calls of the pricer
+    SCIP_Real smoothing = 0.0; ///< dual smoothing factor of the pricer, 0 if the duals were not stabilized
+    size_t mispricings = 0; ///< pricing rounds in which the smoothed duals yielded no improving segment
+    std::vector<MasterNodeStats> master_nodes;
+    std::vector<LpBound> lp_bounds; ///< the master LP value and the Lagrangian bound in each pricing round
+    bool stopped_early = false; ///< whether the pricing was stopped because the Lagrangian bound was close enough to the LP value
+    size_t farkas_rounds = 0; ///< number of calls of the pricer for infeasible master LPs
+    size_t branchings = 0; ///< number of nodes branched on by the assignment branching rule
+    size_t assignment_fixings = 0; ///< number of segment variables fixed to 0 by the branching decisions
+    size_t rounding_calls = 0; ///< number of calls of the rounding heuristic of the master problem
+    size_t rounding_solutions = 0; ///< number of solutions of the rounding heuristic accepted by SCIP
+    size_t columns = 0; ///< number of variables in the master problem at the end of the solve, including the initial segments
+    size_t cut_pool_size = 0; ///< number of components in the cut pool after the last pricing round
+
+    /**
+     * Writes the statistics as a JSON object
+     */
+    void writeJson(std::ostream& out) const;
+
+    /**
+     * Writes the statistics as JSON into the file `filename`
+     * @return false if the file cannot be written
+     */
+    bool writeJson(const std::string& filename) const;
+};
+
+#endif
@@ -0,0 +1,77 @@
+#include "threadpool.h"
+
+ThreadPool::ThreadPool(size_t num_threads) :
+    stop(false), generation(0), active(0), job(nullptr), num_jobs(0), next(0)
+{
+    if (num_threads == 0)
+    {
+        num_threads = std::thread::hardware_concurrency();
+    }
+    for (size_t i = 1; i < num_threads; ++i)
+    {
+        workers.emplace_back(&ThreadPool::work, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    wakeup.notify_all();
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::run(size_t n, const std::function<void(size_t)>& job_)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &job_;
+        num_jobs = n;
+        next = 0;
+        active = workers.size();
+        ++generation;
+    }
+    wakeup.notify_all();
+
+    process(); // the calling thread takes part in the work
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return active == 0; });
+    job = nullptr;
+}
+
+void ThreadPool::process()
+{
+    for (size_t i = next++; i < num_jobs; i = next++)
+    {
+        (*job)(i);
+    }
+}
+
+void ThreadPool::work()
+{
+    size_t seen = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeup.wait(lock, [this, seen] { return stop || generation != seen; });
+            if (stop)
+            {
+                return;
+            }
+            seen = generation;
+        }
+        process();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --active;
+        }
+        done.notify_one();
+    }
+}
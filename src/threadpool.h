@@ -0,0 +1,74 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed-size pool of worker threads
+ * The threads are started once and reused for every call of `run`,
+ * so that no threads have to be created in performance critical loops.
+ */
+class ThreadPool
+{
+public:
+    /**
+     * Starts `num_threads - 1` worker threads; the calling thread acts as the remaining worker
+     */
+    ThreadPool(
+        size_t num_threads ///< total number of threads executing jobs, 0 for one per hardware thread
+        );
+
+    /**
+     * Stops and joins all worker threads
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * Calls `job(i)` for every \f$i\in\{0,\dots,n-1\}\f$ and blocks until all calls have returned
+     * The calls are distributed dynamically over the threads, the order in which they are executed is unspecified.
+     */
+    void run(
+        size_t n, ///< number of jobs
+        const std::function<void(size_t)>& job ///< function to be called with the index of each job
+        );
+
+    /**
+     * @return the total number of threads executing jobs, including the calling thread
+     */
+    size_t size() const
+    {
+        return workers.size() + 1;
+    }
+
+private:
+    /**
+     * Main loop of each worker thread
+     */
+    void work();
+
+    /**
+     * Executes jobs of the current batch until none are left
+     */
+    void process();
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wakeup; ///< signalled when a new batch of jobs is available or the pool is stopped
+    std::condition_variable done; ///< signalled when a worker has finished its share of the current batch
+    bool stop;
+    size_t generation; ///< number of batches started so far
+    size_t active; ///< number of workers still processing the current batch
+    const std::function<void(size_t)>* job;
+    size_t num_jobs;
+    std::atomic<size_t> next; ///< index of the next job to be executed
+};
+
+#endif
@@ -2,35 +2,74 @@
 #define VARDATA_H
 
 #include <objscip/objscip.h>
+#include "column_pool.h"
 #include "graph.h"
 
 using namespace scip;
 
 /**
  * Variable data associated with segment variables \f$x_P\f$ 
+ * The superpixels of the segment \f$P\f$ are stored in the column pool of the pricer, which has to outlive the variable.
  */
 class ObjVardataSegment : public ObjVardata
 {
 public:
     ObjVardataSegment(
-        std::vector<Graph::vertex_descriptor> superpixels_ ///< superpixels contained in the segment \f$P\f$
+        const ColumnPool& pool_, ///< the column pool containing the segment
+        size_t column_ ///< index of the segment \f$P\f$ in `pool_`
         ) :
         ObjVardata(),
-        superpixels(superpixels_)
+        pool(pool_),
+        column(column_)
     {}
     
-    bool containsSuperpixel(Graph::vertex_descriptor superpixel)
+    bool containsSuperpixel(Graph::vertex_descriptor superpixel) const
     {
-        return std::find(superpixels.begin(), superpixels.end(), superpixel) != superpixels.end();
+        return pool.contains(column, superpixel);
     }
     
-    std::vector<Graph::vertex_descriptor> getSuperpixels()
+    /**
+     * @return pointer to the first of the sorted superpixels of the segment
+     */
+    const uint32_t* begin() const
     {
-        return superpixels;
+        return pool.begin(column);
+    }
+
+    const uint32_t* end() const
+    {
+        return pool.end(column);
+    }
+
+    /**
+     * @return the master node of the segment
+     */
+    Graph::vertex_descriptor getMasterNode() const
+    {
+        return pool.masterNode(column);
+    }
+
+    size_t getColumn() const
+    {
+        return column;
     }
     
 private:
-    std::vector<Graph::vertex_descriptor> superpixels;
+    const ColumnPool& pool;
+    size_t column;
 };
 
+/**
+ * @return the variable data of a segment variable, NULL for the artificial initial segments, which have none
+ */
+inline ObjVardataSegment* getSegmentVardata(SCIP* scip, SCIP_VAR* var)
+{
+    // SCIPgetObjVardata dereferences the variable data without checking it
+    if (SCIPvarGetData(var) == NULL)
+    {
+        return NULL;
+    }
+    return static_cast<ObjVardataSegment*>(SCIPgetObjVardata(scip, var));
+}
+
 #endif
@@ -0,0 +1,134 @@
+#include <algorithm>
+#include <limits>
+#include "vertex_separator.h"
+
+VertexSeparator::VertexSeparator(const CsrGraph& g_) :
+    g(g_)
+{
+    size_t n = g.numVertices();
+    node_offsets.resize(2 * n + 1);
+    node_offsets[0] = 0;
+    for (size_t v = 0; v < n; ++v)
+    {
+        // v_in has the arc to v_out and the reverse arcs of u_out -> v_in,
+        // v_out has the reverse arc of v_in -> v_out and the arcs to u_in
+        node_offsets[in(v) + 1] = node_offsets[in(v)] + 1 + g.degree(v);
+        node_offsets[out(v) + 1] = node_offsets[out(v)] + 1 + g.degree(v);
+    }
+    size_t num_arcs = node_offsets[2 * n];
+    heads.resize(num_arcs);
+    reverse.resize(num_arcs);
+    residual.resize(num_arcs);
+
+    for (size_t v = 0; v < n; ++v)
+    {
+        heads[node_offsets[in(v)]] = out(v);
+        reverse[node_offsets[in(v)]] = node_offsets[out(v)];
+        heads[node_offsets[out(v)]] = in(v);
+        reverse[node_offsets[out(v)]] = node_offsets[in(v)];
+        for (size_t k = 0; k < g.degree(v); ++k)
+        {
+            uint32_t u = g.neighboursBegin(v)[k];
+            // position of v among the neighbours of u
+            size_t j = std::find(g.neighboursBegin(u), g.neighboursEnd(u), v) - g.neighboursBegin(u);
+            heads[node_offsets[out(v)] + 1 + k] = in(u);
+            reverse[node_offsets[out(v)] + 1 + k] = node_offsets[in(u)] + 1 + j;
+            heads[node_offsets[in(v)] + 1 + k] = out(u);
+            reverse[node_offsets[in(v)] + 1 + k] = node_offsets[out(u)] + 1 + j;
+        }
+    }
+
+    level.resize(2 * n);
+    queue.resize(2 * n);
+    current.resize(2 * n);
+    separator.resize(n);
+}
+
+SCIP_Real VertexSeparator::minimumSeparator(const SCIP_Real* weights, size_t t, size_t s, SCIP_Real limit, SCIP_Real epsilon)
+{
+    size_t n = g.numVertices();
+    for (size_t v = 0; v < n; ++v)
+    {
+        residual[node_offsets[in(v)]] = (v == t || v == s) ? 0.0 : std::max(weights[v], 0.0);
+        residual[node_offsets[out(v)]] = 0.0;
+        for (uint32_t a = node_offsets[in(v)] + 1; a < node_offsets[in(v) + 1]; ++a)
+        {
+            residual[a] = 0.0;
+        }
+        for (uint32_t a = node_offsets[out(v)] + 1; a < node_offsets[out(v) + 1]; ++a)
+        {
+            residual[a] = std::numeric_limits<SCIP_Real>::infinity();
+        }
+    }
+
+    SCIP_Real flow = 0.0;
+    while (flow < limit - epsilon && computeLevels(out(t), in(s), epsilon))
+    {
+        std::copy(node_offsets.begin(), node_offsets.end() - 1, current.begin());
+        SCIP_Real pushed;
+        while (flow < limit - epsilon && (pushed = augment(out(t), in(s), limit - flow, epsilon)) > epsilon)
+        {
+            flow += pushed;
+        }
+    }
+    return flow;
+}
+
+bool VertexSeparator::computeLevels(uint32_t source, uint32_t sink, SCIP_Real epsilon)
+{
+    std::fill(level.begin(), level.end(), -1);
+    level[source] = 0;
+    queue[0] = source;
+    size_t end = 1;
+    for (size_t head = 0; head < end; ++head)
+    {
+        uint32_t u = queue[head];
+        for (uint32_t a = node_offsets[u]; a < node_offsets[u + 1]; ++a)
+        {
+            if (residual[a] > epsilon && level[heads[a]] < 0)
+            {
+                level[heads[a]] = level[u] + 1;
+                queue[end++] = heads[a];
+            }
+        }
+    }
+    return level[sink] >= 0;
+}
+
+SCIP_Real VertexSeparator::augment(uint32_t u, uint32_t sink, SCIP_Real amount, SCIP_Real epsilon)
+{
+    if (u == sink)
+    {
+        return amount;
+    }
+    for (; current[u] < node_offsets[u + 1]; ++current[u])
+    {
+        uint32_t a = current[u];
+        uint32_t v = heads[a];
+        if (residual[a] > epsilon && level[v] == level[u] + 1)
+        {
+            SCIP_Real pushed = augment(v, sink, std::min(amount, residual[a]), epsilon);
+            if (pushed > epsilon)
+            {
+                residual[a] -= pushed;
+                residual[reverse[a]] += pushed;
+                return pushed;
+            }
+        }
+    }
+    return 0.0;
+}
+
+size_t VertexSeparator::findSeparator()
+{
+    // after the last BFS, the nodes labelled with a level form the source side of a minimum cut
+    size_t size = 0;
+    for (size_t v = 0; v < g.numVertices(); ++v)
+    {
+        if (level[in(v)] >= 0 && level[out(v)] < 0)
+        {
+            separator[size++] = v;
+        }
+    }
+    return size;
+}
@@ -0,0 +1,88 @@
+#ifndef VERTEX_SEPARATOR_H
+#define VERTEX_SEPARATOR_H
+
+#include <cstdint>
+#include <vector>
+#include "csr_graph.h"
+
+/**
+ * Computes minimum weight vertex separators in the superpixel graph using maximum flows
+ * Each superpixel \f$v\f$ is split into an arc \f$v_{in}\to v_{out}\f$ whose capacity is the weight of \f$v\f$,
+ * and every edge \f$\{u,v\}\f$ becomes the arcs \f$u_{out}\to v_{in}\f$ and \f$v_{out}\to u_{in}\f$ of infinite capacity.
+ * A minimum \f$t_{out}\f$-\f$s_{in}\f$ cut then only contains arcs \f$v_{in}\to v_{out}\f$,
+ * which form a minimum weight set of superpixels separating \f$s\f$ from \f$t\f$.
+ *
+ * The arcs of the network are built once in the constructor, each separation only resets their residual capacities.
+ * The flow is computed with Dinic's algorithm.
+ * Superpixels of weight 0 cannot be entered, so only the support of the weights is searched.
+ */
+class VertexSeparator
+{
+public:
+    VertexSeparator(
+        const CsrGraph& g ///< the graph of superpixels
+        );
+
+    /**
+     * Computes a minimum weight set of superpixels separating `s` from `t`
+     * The flow is only augmented until it reaches `limit`, so a separator is only found if its weight is less than `limit`.
+     * Neither `s` nor `t` are contained in the separator, hence no separator exists if they are adjacent.
+     * @return the weight of the separator, or at least `limit` if there is none lighter than `limit`
+     */
+    SCIP_Real minimumSeparator(
+        const SCIP_Real* weights, ///< non-negative weight of each superpixel
+        size_t t, ///< the superpixel on the source side
+        size_t s, ///< the superpixel on the sink side
+        SCIP_Real limit, ///< the flow is not augmented beyond this value
+        SCIP_Real epsilon ///< residual capacities up to this value are treated as 0
+        );
+
+    /**
+     * Collects the superpixels of the separator found by the last call of `minimumSeparator`
+     * The result is only meaningful if the returned weight was less than `limit`.
+     * @return the number of superpixels in the separator, which are stored starting at `separatorBegin()`
+     */
+    size_t findSeparator();
+
+    const uint32_t* separatorBegin() const
+    {
+        return &separator[0];
+    }
+
+private:
+    /**
+     * Labels all nodes reachable from the source in the residual network with their distance
+     * @return whether the sink is reachable
+     */
+    bool computeLevels(uint32_t source, uint32_t sink, SCIP_Real epsilon);
+
+    /**
+     * Sends flow of at most `amount` from `u` to the sink along arcs of increasing level
+     * @return the amount of flow sent
+     */
+    SCIP_Real augment(uint32_t u, uint32_t sink, SCIP_Real amount, SCIP_Real epsilon);
+
+    static uint32_t in(size_t v)
+    {
+        return 2 * v;
+    }
+
+    static uint32_t out(size_t v)
+    {
+        return 2 * v + 1;
+    }
+
+    const CsrGraph& g;
+
+    std::vector<uint32_t> node_offsets; ///< the arcs leaving node u are `node_offsets[u]`, ..., `node_offsets[u+1]-1`
+    std::vector<uint32_t> heads; ///< head of each arc
+    std::vector<uint32_t> reverse; ///< index of the reverse arc of each arc
+    std::vector<SCIP_Real> residual; ///< residual capacity of each arc
+
+    std::vector<int32_t> level; ///< distance of each node from the source in the residual network, -1 if unreachable
+    std::vector<uint32_t> queue; ///< BFS queue of `computeLevels`
+    std::vector<uint32_t> current; ///< next arc to try for each node in `augment`
+    std::vector<uint32_t> separator;
+};
+
+#endif